@@ -3,16 +3,25 @@
 
 namespace async_net {
 
-IoContext::IoContext() : impl_(std::make_unique<detail::IoContextImpl>()) {}
+IoContext::IoContext(const CreateParameters& parameters)
+    : impl_(std::make_unique<detail::IoContextImpl>(parameters)) {}
 IoContext::~IoContext() {
   impl_->drain();
 }
 
-void IoContext::post(std::move_only_function<void()> callback) {
+const IoContext::IoBudgets& IoContext::io_budgets() const {
+  return impl_->io_budgets();
+}
+
+IoContext::Stats IoContext::stats() const {
+  return impl_->stats();
+}
+
+void IoContext::post(Task callback) {
   impl_->queue_deferred_work(std::move(callback));
 }
 
-void IoContext::post_atomic(std::move_only_function<void()> callback) {
+void IoContext::post_atomic(Task callback) {
   impl_->queue_deferred_work_atomic(std::move(callback));
 }
 
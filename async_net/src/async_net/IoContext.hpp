@@ -1,5 +1,6 @@
 #pragma once
-#include <functional>
+#include "Task.hpp"
+
 #include <memory>
 #include <optional>
 
@@ -37,22 +38,70 @@ class IoContext {
     NoMoreWork,
   };
 
+  // Limits how much a single socket can receive or send in one loop iteration (`run` call). All
+  // sends of an iteration count against the same budget, whether they are eager sends, flushes or
+  // writability events. Sockets which still have data left stay readable or writable in the poller
+  // and are continued in the next iteration, after other ready sockets had their turn, so one bulk
+  // transfer cannot starve the rest of the context. There is no context-wide budget: every ready
+  // socket is served in each iteration, so the order in which the poller reports them doesn't
+  // affect their share and an iteration is bounded by the number of ready sockets. These are the
+  // defaults for sockets created in the context, every socket can override them.
+  struct IoBudgets {
+    size_t tcp_receive_bytes = 256 * 1024;
+    size_t tcp_send_bytes = 256 * 1024;
+    size_t udp_receive_datagrams = 64;
+    size_t udp_send_datagrams = 64;
+  };
+
+  struct CreateParameters {
+    IoBudgets io_budgets{};
+
+    // Receive buffers of TCP connections which received nothing for this long and have no
+    // unconsumed data are freed, as well as send buffers which were fully sent. Checked whenever
+    // the context wakes up, so the buffers may be kept longer if there are no events at all.
+    // Disabled when empty.
+    std::optional<base::PreciseTime> idle_buffer_release_after = base::PreciseTime::from_seconds(5);
+
+    // Wait for timers with nanosecond precision instead of rounding the wait up to whole
+    // milliseconds, and run timers which expired during the wait in the same `run` call. On Linux
+    // wakeups can still be delayed by the thread's timer slack (50 us by default).
+    bool precise_timers = false;
+
+    static constexpr CreateParameters default_parameters() { return CreateParameters{}; }
+  };
+
+  // Counters updated by the thread running the context. They can be read from any thread.
+  struct Stats {
+    uint64_t iterations{};
+    uint64_t signaled_entries{};
+    uint64_t accepted_connections{};
+    // Number of currently registered TCP connections.
+    uint64_t tcp_connections{};
+    // Number of times other threads had to interrupt poll to hand work to this context (updated by
+    // these threads).
+    uint64_t wakeups{};
+    base::PreciseTime poll_wait_time{};
+  };
+
   struct RunParameters {
     std::optional<base::PreciseTime> timeout{};
     bool stop_when_no_work{};
   };
 
-  IoContext();
+  explicit IoContext(const CreateParameters& parameters = CreateParameters::default_parameters());
   ~IoContext();
 
-  void post(std::move_only_function<void()> callback);
+  const IoBudgets& io_budgets() const;
+  Stats stats() const;
+
+  void post(Task callback);
 
   template <typename T>
   void post_destroy(T value) {
     post([value_to_destroy = std::move(value)] { (void)value_to_destroy; });
   }
 
-  void post_atomic(std::move_only_function<void()> callback);
+  void post_atomic(Task callback);
 
   [[nodiscard]] RunResult run(const RunParameters& parameters);
   [[nodiscard]] bool run_until_no_work();
@@ -0,0 +1,73 @@
+#include "IoContextPool.hpp"
+
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/concurrency/CoreCount.hpp>
+
+#include <algorithm>
+
+namespace async_net {
+
+void IoContextPool::run_context(IoContext& context) {
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    if (context.run({}) == IoContext::RunResult::Failed) {
+      log_error("failed to run IO context in the pool");
+      failed_ = true;
+      return;
+    }
+  }
+}
+
+IoContextPool::IoContextPool(const CreateParameters& parameters) {
+  const auto context_count =
+    parameters.context_count > 0 ? parameters.context_count
+                                 : std::max<size_t>(base::core_count(), 1);
+
+  contexts_.reserve(context_count);
+  for (size_t i = 0; i < context_count; ++i) {
+    contexts_.push_back(std::make_unique<IoContext>(parameters.context_parameters));
+  }
+}
+
+IoContextPool::~IoContextPool() {
+  stop();
+}
+
+void IoContextPool::start() {
+  verify(!is_running(), "IO context pool is already running");
+
+  stop_requested_ = false;
+  failed_ = false;
+
+  for (auto& context : contexts_) {
+    threads_.spawn([this, &context = *context] { run_context(context); });
+  }
+}
+
+bool IoContextPool::stop() {
+  if (!is_running()) {
+    return !failed_;
+  }
+
+  stop_requested_.store(true, std::memory_order_release);
+  for (auto& context : contexts_) {
+    context->notify();
+  }
+
+  threads_.join();
+
+  return !failed_;
+}
+
+std::vector<IoContext::Stats> IoContextPool::stats() const {
+  std::vector<IoContext::Stats> result;
+  result.reserve(contexts_.size());
+
+  for (const auto& context : contexts_) {
+    result.push_back(context->stats());
+  }
+
+  return result;
+}
+
+}  // namespace async_net
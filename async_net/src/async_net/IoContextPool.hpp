@@ -0,0 +1,60 @@
+#pragma once
+#include "IoContext.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <base/concurrency/JoinableThreads.hpp>
+#include <base/macro/ClassTraits.hpp>
+
+namespace async_net {
+
+// Runs multiple independent IO contexts, each one on its own thread. Objects created in a context
+// must only be used from its thread while the pool is running (contexts can communicate using
+// `IoContext::post_atomic`). To spread incoming connections between threads create a listener in
+// every context with `reuse_port` enabled or hand them off from a single listener using
+// `TcpListener::set_on_accept_handoff`.
+class IoContextPool {
+  std::vector<std::unique_ptr<IoContext>> contexts_;
+  base::JoinableThreads threads_;
+
+  std::atomic_bool stop_requested_{};
+  std::atomic_bool failed_{};
+
+  void run_context(IoContext& context);
+
+ public:
+  struct CreateParameters {
+    // Zero creates one context for every core.
+    size_t context_count = 0;
+    IoContext::CreateParameters context_parameters =
+      IoContext::CreateParameters::default_parameters();
+
+    static constexpr CreateParameters default_parameters() { return CreateParameters{}; }
+  };
+
+  CLASS_NON_COPYABLE_NON_MOVABLE(IoContextPool)
+
+  explicit IoContextPool(
+    const CreateParameters& parameters = CreateParameters::default_parameters());
+  ~IoContextPool();
+
+  size_t size() const { return contexts_.size(); }
+
+  IoContext& context(size_t index) { return *contexts_[index]; }
+  const IoContext& context(size_t index) const { return *contexts_[index]; }
+
+  bool is_running() const { return !threads_.empty(); }
+
+  // Spawns one thread per context. Every thread runs its context until `stop` is called.
+  void start();
+
+  // Stops all threads and waits for them to exit. Returns false if running any context has failed.
+  bool stop();
+
+  std::vector<IoContext::Stats> stats() const;
+};
+
+}  // namespace async_net
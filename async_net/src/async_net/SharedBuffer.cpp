@@ -0,0 +1,52 @@
+#include "SharedBuffer.hpp"
+
+#include <base/Panic.hpp>
+
+#include <cstring>
+
+namespace async_net {
+
+SharedBuffer SharedBuffer::copy(std::span<const uint8_t> data) {
+  if (data.empty()) {
+    return {};
+  }
+
+  auto storage = std::make_shared_for_overwrite<uint8_t[]>(data.size());
+  std::memcpy(storage.get(), data.data(), data.size());
+
+  const std::span<const uint8_t> view{storage.get(), data.size()};
+  return SharedBuffer{std::move(storage), view};
+}
+
+SharedBuffer SharedBuffer::adopt(base::BinaryBuffer buffer) {
+  if (buffer.empty()) {
+    return {};
+  }
+
+  auto storage = std::make_shared<const base::BinaryBuffer>(std::move(buffer));
+  const auto view = storage->span();
+  return SharedBuffer{std::move(storage), view};
+}
+
+SharedBuffer SharedBuffer::adopt(std::vector<uint8_t> buffer) {
+  if (buffer.empty()) {
+    return {};
+  }
+
+  auto storage = std::make_shared<const std::vector<uint8_t>>(std::move(buffer));
+  const std::span<const uint8_t> view{*storage};
+  return SharedBuffer{std::move(storage), view};
+}
+
+SharedBuffer SharedBuffer::slice(size_t offset) const {
+  verify(offset <= size(), "slice out of bounds of SharedBuffer");
+  return SharedBuffer{owner_, data_.subspan(offset)};
+}
+
+SharedBuffer SharedBuffer::slice(size_t offset, size_t size) const {
+  verify(offset <= this->size() && size <= this->size() - offset,
+         "slice out of bounds of SharedBuffer");
+  return SharedBuffer{owner_, data_.subspan(offset, size)};
+}
+
+}  // namespace async_net
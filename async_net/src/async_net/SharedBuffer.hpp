@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <base/containers/BinaryBuffer.hpp>
+
+namespace async_net {
+
+// Immutable, reference counted bytes. Copies only share the ownership, so the same data can be
+// queued on many connections (see `TcpConnection::send_shared`) without copying it for each of
+// them. It's freed when the last reference goes away.
+class SharedBuffer {
+  std::shared_ptr<const void> owner_;
+  std::span<const uint8_t> data_;
+
+  SharedBuffer(std::shared_ptr<const void> owner, std::span<const uint8_t> data)
+      : owner_(std::move(owner)), data_(data) {}
+
+ public:
+  SharedBuffer() = default;
+
+  // Copies the data into a new allocation.
+  static SharedBuffer copy(std::span<const uint8_t> data);
+
+  // Take over the contents of the buffer without copying them.
+  static SharedBuffer adopt(base::BinaryBuffer buffer);
+  static SharedBuffer adopt(std::vector<uint8_t> buffer);
+
+  size_t size() const { return data_.size(); }
+  bool empty() const { return data_.empty(); }
+
+  const uint8_t* data() const { return data_.data(); }
+
+  std::span<const uint8_t> span() const { return data_; }
+  operator std::span<const uint8_t>() const { return data_; }
+
+  // Part of this buffer which shares its ownership.
+  SharedBuffer slice(size_t offset) const;
+  SharedBuffer slice(size_t offset, size_t size) const;
+};
+
+}  // namespace async_net
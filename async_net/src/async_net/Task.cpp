@@ -0,0 +1 @@
+#include "Task.hpp"
\ No newline at end of file
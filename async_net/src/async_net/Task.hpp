@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <base/macro/ClassTraits.hpp>
+
+// Set by the build system (ASYNC_NET_TASK_INLINE_SIZE CMake variable).
+#ifndef ASYNC_NET_TASK_INLINE_SIZE
+#define ASYNC_NET_TASK_INLINE_SIZE 64
+#endif
+
+namespace async_net {
+
+// Move-only `void()` callable used for deferred work and timer callbacks. Unlike
+// `std::move_only_function` (which only has room for two pointers) callables up to `InlineSize`
+// bytes are stored inline, so typical lambdas capturing a `shared_ptr` and a few values don't
+// allocate.
+template <size_t InlineSize>
+class BasicTask {
+  static_assert(InlineSize >= sizeof(void*), "inline storage must be able to hold a pointer");
+
+  struct Operations {
+    void (*invoke)(void* storage);
+    // Moves the callable to uninitialized `destination` storage and destroys the source.
+    void (*relocate)(void* source, void* destination);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename F>
+  struct InlineOperations {
+    static F& get(void* storage) { return *std::launder(static_cast<F*>(storage)); }
+
+    constexpr static Operations operations{
+      .invoke = [](void* storage) { get(storage)(); },
+      .relocate =
+        [](void* source, void* destination) {
+          new (destination) F(std::move(get(source)));
+          get(source).~F();
+        },
+      .destroy = [](void* storage) { get(storage).~F(); },
+    };
+  };
+
+  template <typename F>
+  struct HeapOperations {
+    static F*& get(void* storage) { return *std::launder(static_cast<F**>(storage)); }
+
+    constexpr static Operations operations{
+      .invoke = [](void* storage) { (*get(storage))(); },
+      .relocate = [](void* source, void* destination) { new (destination) F*(get(source)); },
+      .destroy = [](void* storage) { delete get(storage); },
+    };
+  };
+
+  alignas(std::max_align_t) uint8_t storage_[InlineSize];
+  const Operations* operations_{};
+
+  void reset() {
+    if (operations_) {
+      operations_->destroy(storage_);
+      operations_ = nullptr;
+    }
+  }
+
+ public:
+  constexpr static size_t inline_size = InlineSize;
+
+  template <typename F>
+  constexpr static bool is_stored_inline = sizeof(F) <= InlineSize &&
+                                           alignof(F) <= alignof(std::max_align_t) &&
+                                           std::is_nothrow_move_constructible_v<F>;
+
+  CLASS_NON_COPYABLE(BasicTask)
+
+  BasicTask() = default;
+
+  template <typename Fn>
+    requires(!std::is_same_v<std::remove_cvref_t<Fn>, BasicTask> &&
+             std::is_invocable_v<std::decay_t<Fn>&>)
+  BasicTask(Fn&& callable) {
+    using F = std::decay_t<Fn>;
+
+    if constexpr (is_stored_inline<F>) {
+      new (storage_) F(std::forward<Fn>(callable));
+      operations_ = &InlineOperations<F>::operations;
+    } else {
+      new (storage_) F*(new F(std::forward<Fn>(callable)));
+      operations_ = &HeapOperations<F>::operations;
+    }
+  }
+
+  ~BasicTask() { reset(); }
+
+  BasicTask(BasicTask&& other) noexcept : operations_(other.operations_) {
+    if (operations_) {
+      operations_->relocate(other.storage_, storage_);
+      other.operations_ = nullptr;
+    }
+  }
+
+  BasicTask& operator=(BasicTask&& other) noexcept {
+    if (this != &other) {
+      reset();
+
+      if (other.operations_) {
+        other.operations_->relocate(other.storage_, storage_);
+        operations_ = std::exchange(other.operations_, nullptr);
+      }
+    }
+    return *this;
+  }
+
+  explicit operator bool() const { return operations_ != nullptr; }
+
+  void operator()() { operations_->invoke(storage_); }
+};
+
+using Task = BasicTask<ASYNC_NET_TASK_INLINE_SIZE>;
+
+}  // namespace async_net
@@ -3,12 +3,20 @@
 #include "detail/TcpConnectionImpl.hpp"
 #include "detail/UpdateCallback.hpp"
 
+#include <base/Panic.hpp>
+
 namespace async_net {
 
 base::BinaryBuffer* TcpConnection::acquire_send_buffer() {
   return impl_ ? &impl_->acquire_send_buffer() : nullptr;
 }
 
+void TcpConnection::release_send_buffer() {
+  if (impl_) {
+    impl_->release_send_buffer();
+  }
+}
+
 TcpConnection::TcpConnection(IoContext& context, sock::StreamSocket socket)
     : impl_(std::make_shared<detail::TcpConnectionImpl>(context)) {
   impl_->startup(impl_, std::move(socket));
@@ -103,6 +111,7 @@ size_t TcpConnection::max_send_buffer_size() const {
 void TcpConnection::set_max_send_buffer_size(size_t size) {
   if (impl_) {
     impl_->send_buffer_max_size = size;
+    impl_->request_poll_update();
   }
 }
 
@@ -113,6 +122,7 @@ bool TcpConnection::block_on_send_buffer_full() const {
 void TcpConnection::set_block_on_send_buffer_full(bool block) {
   if (impl_) {
     impl_->block_on_send_buffer_full = block;
+    impl_->request_poll_update();
   }
 }
 
@@ -123,6 +133,69 @@ bool TcpConnection::receive_packets() const {
 void TcpConnection::set_receive_packets(bool receive) const {
   if (impl_) {
     impl_->receive_packets = receive;
+    impl_->request_poll_update();
+  }
+}
+
+bool TcpConnection::eager_send() const {
+  return impl_ ? impl_->eager_send : false;
+}
+
+void TcpConnection::set_eager_send(bool eager) {
+  if (impl_) {
+    impl_->eager_send = eager;
+  }
+}
+
+bool TcpConnection::cork_sends() const {
+  return impl_ ? impl_->cork_sends : false;
+}
+
+void TcpConnection::set_cork_sends(bool cork) {
+  if (impl_) {
+    impl_->cork_sends = cork;
+  }
+}
+
+bool TcpConnection::no_delay() const {
+  return impl_ ? impl_->no_delay : false;
+}
+
+void TcpConnection::set_no_delay(bool no_delay) {
+  if (impl_) {
+    impl_->set_no_delay(no_delay);
+  }
+}
+
+size_t TcpConnection::zero_copy_threshold() const {
+  return impl_ ? impl_->zero_copy_threshold : 0;
+}
+
+void TcpConnection::set_zero_copy_threshold(size_t threshold) {
+  if (impl_) {
+    impl_->set_zero_copy_threshold(threshold);
+  }
+}
+
+size_t TcpConnection::receive_budget() const {
+  return impl_ ? impl_->receive_budget : 0;
+}
+
+void TcpConnection::set_receive_budget(size_t bytes) {
+  verify(bytes > 0, "receive budget must be non-zero");
+  if (impl_) {
+    impl_->receive_budget = bytes;
+  }
+}
+
+size_t TcpConnection::send_budget() const {
+  return impl_ ? impl_->send_budget : 0;
+}
+
+void TcpConnection::set_send_budget(size_t bytes) {
+  verify(bytes > 0, "send budget must be non-zero");
+  if (impl_) {
+    impl_->send_budget = bytes;
   }
 }
 
@@ -134,6 +207,58 @@ bool TcpConnection::send_data_force(std::span<const uint8_t> data) {
   return send_force([&](base::BinaryBuffer& buffer) { buffer.append(data); });
 }
 
+bool TcpConnection::send_data_vectored(std::span<const std::span<const uint8_t>> slices) {
+  if (!is_send_buffer_full()) {
+    return send_data_vectored_force(slices);
+  }
+  return false;
+}
+
+bool TcpConnection::send_data_vectored_force(std::span<const std::span<const uint8_t>> slices) {
+  if (impl_) {
+    impl_->send_data_vectored(slices);
+    return true;
+  }
+  return false;
+}
+
+bool TcpConnection::send_shared(SharedBuffer buffer) {
+  if (!is_send_buffer_full()) {
+    return send_shared_force(std::move(buffer));
+  }
+  return false;
+}
+
+bool TcpConnection::send_shared_force(SharedBuffer buffer) {
+  if (impl_) {
+    impl_->queue_shared_buffer(std::move(buffer));
+    return true;
+  }
+  return false;
+}
+
+bool TcpConnection::send_file(int file_descriptor, uint64_t offset, size_t size) {
+  if (!is_send_buffer_full()) {
+    return send_file_force(file_descriptor, offset, size);
+  }
+  return false;
+}
+
+bool TcpConnection::send_file_force(int file_descriptor, uint64_t offset, size_t size) {
+  if (impl_ && sock::StreamSocket::is_send_file_supported()) {
+    impl_->queue_file(file_descriptor, offset, size);
+    return true;
+  }
+  return false;
+}
+
+bool TcpConnection::relay_to(TcpConnection& destination) {
+  if (impl_ && destination.impl_) {
+    return impl_->relay_to(*destination.impl_);
+  }
+  return false;
+}
+
 void TcpConnection::shutdown() {
   if (impl_) {
     impl_->shutdown(impl_);
@@ -156,6 +281,7 @@ void TcpConnection::set_on_data_received(
   std::move_only_function<size_t(std::span<const uint8_t>)> callback) {
   if (impl_) {
     detail::update_callback(impl_->context, impl_->on_data_received, std::move(callback));
+    impl_->request_poll_update();
   }
 }
 void TcpConnection::set_on_data_sent(std::move_only_function<void()> callback) {
@@ -1,5 +1,6 @@
 #pragma once
 #include "IpAddress.hpp"
+#include "SharedBuffer.hpp"
 #include "Status.hpp"
 
 #include <cstdint>
@@ -22,15 +23,18 @@ class IoContext;
 
 namespace detail {
 class IoContextImpl;
+class TcpConnectionHandoff;
 class TcpConnectionImpl;
 }  // namespace detail
 
 class TcpConnection {
   friend detail::IoContextImpl;
+  friend detail::TcpConnectionHandoff;
 
   std::shared_ptr<detail::TcpConnectionImpl> impl_;
 
   base::BinaryBuffer* acquire_send_buffer();
+  void release_send_buffer();
 
   TcpConnection(IoContext& context, sock::StreamSocket socket);
 
@@ -84,15 +88,75 @@ class TcpConnection {
   bool receive_packets() const;
   void set_receive_packets(bool receive) const;
 
+  // Sends newly queued data immediately instead of waiting for the next poll (unless the socket
+  // has been blocked by a previous send).
+  bool eager_send() const;
+  void set_eager_send(bool eager);
+
+  // Delays eager sends until the end of the current loop iteration so that data queued by multiple
+  // send calls is sent with a single send().
+  bool cork_sends() const;
+  void set_cork_sends(bool cork);
+
+  bool no_delay() const;
+  void set_no_delay(bool no_delay);
+
+  // Shared buffers (see `send_shared`) with at least this many bytes left to send are sent with
+  // MSG_ZEROCOPY: the kernel transmits straight from their memory and they are kept alive until it
+  // reports that it's done with them. Copied data is always sent normally. It only pays off for
+  // large payloads, small ones are cheaper to copy than to track. 0 disables zero-copy sends, which
+  // is the default. The threshold is reset to 0 on platforms without support for them and when the
+  // kernel reports that it had to copy the data anyway (e.g. on loopback).
+  size_t zero_copy_threshold() const;
+  void set_zero_copy_threshold(size_t threshold);
+
+  // Maximum number of bytes received from and sent to the socket in one loop iteration (defaults
+  // come from `IoContext::IoBudgets`).
+  size_t receive_budget() const;
+  void set_receive_budget(size_t bytes);
+  size_t send_budget() const;
+  void set_send_budget(size_t bytes);
+
   [[nodiscard]] bool send_data(std::span<const uint8_t> data);
   bool send_data_force(std::span<const uint8_t> data);
 
+  // Sends the slices as if they were concatenated. If nothing is waiting in the send buffer they
+  // are written directly with a single vectored send and only the part which didn't fit into the
+  // socket is copied, so callers can pass a header and a payload without joining them first.
+  [[nodiscard]] bool send_data_vectored(std::span<const std::span<const uint8_t>> slices);
+  bool send_data_vectored_force(std::span<const std::span<const uint8_t>> slices);
+
+  // Queues the buffer without copying it, it's kept alive until it has been sent. It's sent in
+  // order with the data queued by other send calls, so e.g. a per-connection header can be sent
+  // before a payload shared by many connections.
+  [[nodiscard]] bool send_shared(SharedBuffer buffer);
+  bool send_shared_force(SharedBuffer buffer);
+
+  // Streams `size` bytes of the file starting at `offset` with sendfile() (Linux only), in order
+  // with data queued by other send calls. The kernel reads the file while sending, so the
+  // descriptor has to stay open and the range unchanged until then (e.g. until the send buffer is
+  // empty in `on_data_sent`). Returns false if it isn't supported or the send buffer is full.
+  [[nodiscard]] bool send_file(int file_descriptor, uint64_t offset, size_t size);
+  bool send_file_force(int file_descriptor, uint64_t offset, size_t size);
+
+  // Forwards everything received on this connection to `destination` with splice() through a
+  // kernel pipe (Linux only), so the data never enters userspace and `on_data_received` isn't
+  // called. Receiving pauses while the pipe is full, i.e. while `destination` can't keep up.
+  // It can be started from `on_data_received` (e.g. after parsing a header), data the callback
+  // doesn't consume is forwarded once it returns.
+  // Relayed data is sent once the data already queued on `destination` has been sent. The relay
+  // ends when either connection closes, data left in the pipe is still sent if this one closed
+  // first. Returns false if relaying isn't supported, `destination` is this connection, either
+  // connection isn't connected or already takes part in a relay in the same direction.
+  [[nodiscard]] bool relay_to(TcpConnection& destination);
+
   template <typename Fn>
   [[nodiscard]] bool send(Fn&& fn) {
     if (!is_send_buffer_full()) {
       const auto buffer = acquire_send_buffer();
       if (buffer) {
         fn(*buffer);
+        release_send_buffer();
         return true;
       }
     }
@@ -105,6 +169,7 @@ class TcpConnection {
     const auto buffer = acquire_send_buffer();
     if (buffer) {
       fn(*buffer);
+      release_send_buffer();
       return true;
     }
 
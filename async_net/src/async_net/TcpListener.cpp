@@ -1,30 +1,41 @@
 #include "TcpListener.hpp"
 #include "IoContext.hpp"
+#include "detail/TcpConnectionHandoff.hpp"
 #include "detail/TcpListenerImpl.hpp"
 #include "detail/UpdateCallback.hpp"
 
 namespace async_net {
 
-TcpListener::TcpListener(IoContext& context, std::string hostname, uint16_t port)
+TcpListener::TcpListener(IoContext& context,
+                         std::string hostname,
+                         uint16_t port,
+                         BindParameters parameters)
     : impl_(std::make_shared<detail::TcpListenerImpl>(context)) {
-  impl_->startup(impl_, std::move(hostname), port);
+  impl_->startup(impl_, std::move(hostname), port, parameters);
 }
 
-TcpListener::TcpListener(IoContext& context, const IpAddress& address, uint16_t port)
-    : TcpListener(context, SocketAddress{address, port}) {}
+TcpListener::TcpListener(IoContext& context,
+                         const IpAddress& address,
+                         uint16_t port,
+                         BindParameters parameters)
+    : TcpListener(context, SocketAddress{address, port}, parameters) {}
 
-TcpListener::TcpListener(IoContext& context, const SocketAddress& address)
+TcpListener::TcpListener(IoContext& context,
+                         const SocketAddress& address,
+                         BindParameters parameters)
     : impl_(std::make_shared<detail::TcpListenerImpl>(context)) {
-  impl_->startup(impl_, address);
+  impl_->startup(impl_, address, parameters);
 }
 
-TcpListener::TcpListener(IoContext& context, std::vector<SocketAddress> addresses)
+TcpListener::TcpListener(IoContext& context,
+                         std::vector<SocketAddress> addresses,
+                         BindParameters parameters)
     : impl_(std::make_shared<detail::TcpListenerImpl>(context)) {
-  impl_->startup(impl_, std::move(addresses));
+  impl_->startup(impl_, std::move(addresses), parameters);
 }
 
-TcpListener::TcpListener(IoContext& context, uint16_t port)
-    : TcpListener(context, SocketAddress{IpAddress::unspecified(), port}) {}
+TcpListener::TcpListener(IoContext& context, uint16_t port, BindParameters parameters)
+    : TcpListener(context, SocketAddress{IpAddress::unspecified(), port}, parameters) {}
 
 TcpListener::~TcpListener() {
   if (impl_) {
@@ -65,6 +76,7 @@ bool TcpListener::accept_connections() const {
 void TcpListener::set_accept_connections(bool accept) const {
   if (impl_) {
     impl_->accept_connections = accept;
+    impl_->request_poll_update();
   }
 }
 
@@ -90,6 +102,19 @@ void TcpListener::set_on_error(std::move_only_function<void(Status)> callback) {
 void TcpListener::set_on_accept(std::move_only_function<void(Status, TcpConnection)> callback) {
   if (impl_) {
     detail::update_callback(impl_->context, impl_->on_accept, std::move(callback));
+    impl_->request_poll_update();
+  }
+}
+
+void TcpListener::set_on_accept_handoff(
+  IoContextPool& pool,
+  HandoffPolicy policy,
+  std::move_only_function<void(TcpConnection) const> callback) {
+  if (impl_) {
+    detail::update_callback(
+      impl_->context, impl_->handoff,
+      std::make_shared<detail::TcpConnectionHandoff>(pool, policy, std::move(callback)));
+    impl_->request_poll_update();
   }
 }
 
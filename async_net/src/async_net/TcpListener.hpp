@@ -13,6 +13,7 @@
 namespace async_net {
 
 class IoContext;
+class IoContextPool;
 class TcpConnection;
 
 namespace detail {
@@ -30,15 +31,43 @@ class TcpListener {
     Shutdown,
   };
 
+  enum class HandoffPolicy {
+    RoundRobin,
+    LeastConnections,
+  };
+
+  struct BindParameters {
+    // Allows listeners in multiple contexts (threads) to bind the same port. The kernel spreads
+    // incoming connections between them.
+    bool reuse_port = false;
+
+    // Size of the kernel queue of connections which weren't accepted yet.
+    uint32_t max_pending_connections = 16;
+
+    static constexpr BindParameters default_parameters() { return BindParameters{}; }
+  };
+
   CLASS_NON_COPYABLE(TcpListener)
 
   TcpListener() = default;
 
-  TcpListener(IoContext& context, std::string hostname, uint16_t port);
-  TcpListener(IoContext& context, const IpAddress& address, uint16_t port);
-  TcpListener(IoContext& context, const SocketAddress& address);
-  TcpListener(IoContext& context, std::vector<SocketAddress> addresses);
-  TcpListener(IoContext& context, uint16_t port);
+  TcpListener(IoContext& context,
+              std::string hostname,
+              uint16_t port,
+              BindParameters parameters = BindParameters::default_parameters());
+  TcpListener(IoContext& context,
+              const IpAddress& address,
+              uint16_t port,
+              BindParameters parameters = BindParameters::default_parameters());
+  TcpListener(IoContext& context,
+              const SocketAddress& address,
+              BindParameters parameters = BindParameters::default_parameters());
+  TcpListener(IoContext& context,
+              std::vector<SocketAddress> addresses,
+              BindParameters parameters = BindParameters::default_parameters());
+  TcpListener(IoContext& context,
+              uint16_t port,
+              BindParameters parameters = BindParameters::default_parameters());
   ~TcpListener();
 
   TcpListener(TcpListener&& other) noexcept;
@@ -62,6 +91,14 @@ class TcpListener {
   void set_on_listening(std::move_only_function<void()> callback);
   void set_on_error(std::move_only_function<void(Status)> callback);
   void set_on_accept(std::move_only_function<void(Status, TcpConnection)> callback);
+
+  // Hands accepted connections off to contexts of `pool` instead of passing them to `on_accept`
+  // (which still receives accept errors). `callback` is called on the thread of the target context
+  // with a connection created in that context, so it may run concurrently on multiple threads
+  // (hence it has to be callable as const).
+  void set_on_accept_handoff(IoContextPool& pool,
+                             HandoffPolicy policy,
+                             std::move_only_function<void(TcpConnection) const> callback);
 };
 
 }  // namespace async_net
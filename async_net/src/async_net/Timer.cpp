@@ -37,28 +37,22 @@ Timer::~Timer() {
   reset();
 }
 
-Timer Timer::invoke_at_deadline(IoContext& context,
-                                base::PreciseTime deadline,
-                                std::move_only_function<void()> callback) {
+Timer Timer::invoke_at_deadline(IoContext& context, base::PreciseTime deadline, Task callback) {
   const auto key = context.impl_->register_timer(deadline, std::move(callback));
   return Timer{context, key.id, key.deadline};
 }
 
-Timer Timer::invoke_after(IoContext& context,
-                          base::PreciseTime timeout,
-                          std::move_only_function<void()> callback) {
+Timer Timer::invoke_after(IoContext& context, base::PreciseTime timeout, Task callback) {
   return invoke_at_deadline(context, base::PreciseTime::now() + timeout, std::move(callback));
 }
 
 void Timer::invoke_at_deadline_detached(IoContext& context,
                                         base::PreciseTime deadline,
-                                        std::move_only_function<void()> callback) {
+                                        Task callback) {
   context.impl_->register_timer(deadline, std::move(callback));
 }
 
-void Timer::invoke_after_detached(IoContext& context,
-                                  base::PreciseTime timeout,
-                                  std::move_only_function<void()> callback) {
+void Timer::invoke_after_detached(IoContext& context, base::PreciseTime timeout, Task callback) {
   invoke_at_deadline_detached(context, base::PreciseTime::now() + timeout, std::move(callback));
 }
 
@@ -1,6 +1,7 @@
 #pragma once
+#include "Task.hpp"
+
 #include <cstdint>
-#include <functional>
 #include <limits>
 
 #include <base/macro/ClassTraits.hpp>
@@ -25,19 +26,13 @@ class Timer {
   Timer() = default;
   ~Timer();
 
-  static Timer invoke_at_deadline(IoContext& context,
-                                  base::PreciseTime deadline,
-                                  std::move_only_function<void()> callback);
-  static Timer invoke_after(IoContext& context,
-                            base::PreciseTime timeout,
-                            std::move_only_function<void()> callback);
+  static Timer invoke_at_deadline(IoContext& context, base::PreciseTime deadline, Task callback);
+  static Timer invoke_after(IoContext& context, base::PreciseTime timeout, Task callback);
 
   static void invoke_at_deadline_detached(IoContext& context,
                                           base::PreciseTime deadline,
-                                          std::move_only_function<void()> callback);
-  static void invoke_after_detached(IoContext& context,
-                                    base::PreciseTime timeout,
-                                    std::move_only_function<void()> callback);
+                                          Task callback);
+  static void invoke_after_detached(IoContext& context, base::PreciseTime timeout, Task callback);
 
   Timer(Timer&& other) noexcept;
   Timer& operator=(Timer&& other) noexcept;
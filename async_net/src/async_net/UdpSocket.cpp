@@ -2,6 +2,8 @@
 #include "detail/UdpSocketImpl.hpp"
 #include "detail/UpdateCallback.hpp"
 
+#include <base/Panic.hpp>
+
 namespace async_net {
 
 UdpSocket::UdpSocket(IoContext& context,
@@ -91,7 +93,7 @@ size_t UdpSocket::pending_to_send() const {
 }
 
 bool UdpSocket::is_send_buffer_empty() const {
-  return impl_ ? impl_->send_entries.empty() : true;
+  return impl_ ? impl_->send_queue.empty() : true;
 }
 
 bool UdpSocket::is_send_buffer_full() const {
@@ -105,6 +107,7 @@ size_t UdpSocket::max_send_buffer_size() const {
 void UdpSocket::set_max_send_buffer_size(size_t size) {
   if (impl_) {
     impl_->send_buffer_max_size = size;
+    impl_->request_poll_update();
   }
 }
 
@@ -115,6 +118,17 @@ bool UdpSocket::block_on_send_buffer_full() const {
 void UdpSocket::set_block_on_send_buffer_full(bool block) {
   if (impl_) {
     impl_->block_on_send_buffer_full = block;
+    impl_->request_poll_update();
+  }
+}
+
+bool UdpSocket::flush_immediately() const {
+  return impl_ ? impl_->flush_immediately : false;
+}
+
+void UdpSocket::set_flush_immediately(bool flush) {
+  if (impl_) {
+    impl_->flush_immediately = flush;
   }
 }
 
@@ -125,6 +139,29 @@ bool UdpSocket::receive_packets() const {
 void UdpSocket::set_receive_packets(bool receive) const {
   if (impl_) {
     impl_->receive_packets = receive;
+    impl_->request_poll_update();
+  }
+}
+
+size_t UdpSocket::receive_budget() const {
+  return impl_ ? impl_->receive_budget : 0;
+}
+
+void UdpSocket::set_receive_budget(size_t datagrams) {
+  verify(datagrams > 0, "receive budget must be non-zero");
+  if (impl_) {
+    impl_->receive_budget = datagrams;
+  }
+}
+
+size_t UdpSocket::send_budget() const {
+  return impl_ ? impl_->send_budget : 0;
+}
+
+void UdpSocket::set_send_budget(size_t datagrams) {
+  verify(datagrams > 0, "send budget must be non-zero");
+  if (impl_) {
+    impl_->send_budget = datagrams;
   }
 }
 
@@ -132,6 +169,12 @@ bool UdpSocket::send_data(const SocketAddress& destination, std::span<const uint
   return impl_ ? impl_->send_data(destination, data) : false;
 }
 
+bool UdpSocket::send_segmented_data(const SocketAddress& destination,
+                                    std::span<const uint8_t> data,
+                                    size_t segment_size) {
+  return impl_ ? impl_->send_segmented_data(destination, data, segment_size) : false;
+}
+
 void UdpSocket::shutdown() {
   if (impl_) {
     impl_->shutdown(impl_);
@@ -155,6 +198,15 @@ void UdpSocket::set_on_data_received(
   std::move_only_function<void(const SocketAddress&, std::span<const uint8_t>)> callback) {
   if (impl_) {
     detail::update_callback(impl_->context, impl_->on_data_received, std::move(callback));
+    impl_->request_poll_update();
+  }
+}
+
+void UdpSocket::set_on_batch_received(
+  std::move_only_function<void(std::span<const ReceivedDatagram>)> callback) {
+  if (impl_) {
+    detail::update_callback(impl_->context, impl_->on_batch_received, std::move(callback));
+    impl_->request_poll_update();
   }
 }
 
@@ -33,9 +33,20 @@ class UdpSocket {
     Shutdown,
   };
 
+  struct ReceivedDatagram {
+    SocketAddress peer;
+    std::span<const uint8_t> data;
+  };
+
   struct BindParameters {
     bool reuse_port = false;
     bool allow_broadcast = false;
+    // Lets the kernel split data queued by `send_segmented_data` into datagrams (UDP GSO, Linux
+    // only). Otherwise every segment is sent as a separate datagram.
+    bool segmentation_offload = false;
+    // Lets the kernel coalesce datagrams received from one sender (UDP GRO, Linux only). They're
+    // split back into separate datagrams before invoking the receive callbacks.
+    bool receive_coalescing = false;
 
     static constexpr BindParameters default_parameters() { return BindParameters{}; }
   };
@@ -92,10 +103,27 @@ class UdpSocket {
   bool block_on_send_buffer_full() const;
   void set_block_on_send_buffer_full(bool block);
 
+  // Sends queued datagrams at the end of the current loop iteration instead of waiting for the
+  // poller to report the socket as writable. Datagrams queued until then are still sent in batches.
+  bool flush_immediately() const;
+  void set_flush_immediately(bool flush);
+
   bool receive_packets() const;
   void set_receive_packets(bool receive) const;
 
+  // Maximum number of datagrams received and sent in one loop iteration (defaults come from
+  // `IoContext::IoBudgets`).
+  size_t receive_budget() const;
+  void set_receive_budget(size_t datagrams);
+  size_t send_budget() const;
+  void set_send_budget(size_t datagrams);
+
   bool send_data(const SocketAddress& destination, std::span<const uint8_t> data);
+  // Sends `data` as consecutive datagrams of `segment_size` bytes (the last one can be shorter).
+  // With `BindParameters::segmentation_offload` up to 64 of them are sent with one system call.
+  bool send_segmented_data(const SocketAddress& destination,
+                           std::span<const uint8_t> data,
+                           size_t segment_size);
 
   void shutdown();
 
@@ -106,6 +134,11 @@ class UdpSocket {
     std::move_only_function<void(const SocketAddress&, std::span<const uint8_t>)> callback);
   void set_on_data_sent(std::move_only_function<void()> callback);
 
+  // Called once with all datagrams received by a single system call instead of calling
+  // `on_data_received` for each of them. The data is only valid during the callback.
+  void set_on_batch_received(
+    std::move_only_function<void(std::span<const ReceivedDatagram>)> callback);
+
   void set_on_send_error(std::move_only_function<void(Status)> callback);
 };
 
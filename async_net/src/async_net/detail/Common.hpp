@@ -8,5 +8,19 @@ namespace async_net::detail {
 constexpr size_t invalid_context_index = std::numeric_limits<size_t>::max();
 constexpr size_t default_send_buffer_max_size = 8 * 1024 * 1024;
 constexpr size_t max_datagram_size = std::numeric_limits<uint16_t>::max();
+// Number of datagrams received with a single system call. Every one gets a slot that fits the
+// largest datagram, the slots are never zero-filled so only pages touched by received data get
+// backed by memory.
+constexpr size_t udp_receive_batch_size = 32;
+// Maximum number of queued datagrams sent with a single system call.
+constexpr size_t udp_send_batch_size = 64;
+// Largest buffer split into datagrams by the kernel in a single send (maximum UDP payload size of
+// an IPv4 packet, which is also below the IPv6 limit).
+constexpr size_t max_segmented_send_size = 65507;
+
+// Bounds of the adaptive size of a single TCP receive.
+constexpr size_t min_receive_fragment_size = 512;
+constexpr size_t initial_receive_fragment_size = 4 * 1024;
+constexpr size_t max_receive_fragment_size = 256 * 1024;
 
 }  // namespace async_net::detail
\ No newline at end of file
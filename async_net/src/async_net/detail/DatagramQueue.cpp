@@ -0,0 +1,130 @@
+#include "DatagramQueue.hpp"
+
+#include <base/Panic.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace async_net::detail {
+
+constexpr static size_t initial_entry_capacity = 64;
+constexpr static size_t initial_buffer_capacity = 64 * 1024;
+
+bool DatagramQueue::find_space(size_t size, size_t& offset, size_t& skipped_size) const {
+  const bool wrapped = read_offset + used_size != write_offset;
+
+  if (!wrapped) {
+    if (buffer_capacity - write_offset >= size) {
+      offset = write_offset;
+      skipped_size = 0;
+      return true;
+    }
+
+    // Skip the end of the buffer and continue from its beginning.
+    if (read_offset >= size) {
+      offset = 0;
+      skipped_size = buffer_capacity - write_offset;
+      return true;
+    }
+  } else if (read_offset - write_offset >= size) {
+    offset = write_offset;
+    skipped_size = 0;
+    return true;
+  }
+
+  return false;
+}
+
+void DatagramQueue::grow_entries() {
+  std::vector<Entry> new_entries(std::max(entries.size() * 2, initial_entry_capacity));
+  for (size_t i = 0; i < entry_count; ++i) {
+    new_entries[i] = (*this)[i];
+  }
+
+  entries = std::move(new_entries);
+  first_entry = 0;
+}
+
+void DatagramQueue::grow_buffer(size_t required_size) {
+  auto new_capacity = std::max(buffer_capacity * 2, initial_buffer_capacity);
+  while (new_capacity < total_data_size + required_size) {
+    new_capacity *= 2;
+  }
+
+  // Queued payloads are moved to the beginning of the new buffer without any gaps.
+  auto new_buffer = std::make_unique_for_overwrite<uint8_t[]>(new_capacity);
+  size_t offset = 0;
+
+  for (size_t i = 0; i < entry_count; ++i) {
+    auto& entry = entries[(first_entry + i) & (entries.size() - 1)];
+    if (entry.data_size > 0) {
+      std::memcpy(new_buffer.get() + offset, buffer.get() + entry.data_offset, entry.data_size);
+    }
+
+    entry.data_offset = offset;
+    entry.occupied_size = entry.data_size;
+    offset += entry.data_size;
+  }
+
+  buffer = std::move(new_buffer);
+  buffer_capacity = new_capacity;
+  read_offset = 0;
+  write_offset = offset;
+  used_size = offset;
+}
+
+void DatagramQueue::push(const SocketAddress& destination,
+                         std::span<const uint8_t> data,
+                         uint16_t segment_size) {
+  if (entry_count == entries.size()) {
+    grow_entries();
+  }
+
+  size_t offset = 0;
+  size_t skipped_size = 0;
+  if (!find_space(data.size(), offset, skipped_size)) {
+    grow_buffer(data.size());
+    verify(find_space(data.size(), offset, skipped_size), "failed to allocate datagram space");
+  }
+
+  if (!data.empty()) {
+    std::memcpy(buffer.get() + offset, data.data(), data.size());
+  }
+
+  entries[(first_entry + entry_count) & (entries.size() - 1)] = {
+    .destination = destination,
+    .segment_size = segment_size,
+    .data_offset = offset,
+    .data_size = data.size(),
+    .occupied_size = skipped_size + data.size(),
+  };
+  entry_count++;
+
+  write_offset = offset + data.size();
+  used_size += skipped_size + data.size();
+  total_data_size += data.size();
+}
+
+void DatagramQueue::pop(size_t count) {
+  verify(count <= entry_count, "popping more datagrams than queued");
+
+  for (size_t i = 0; i < count; ++i) {
+    const auto& entry = entries[first_entry];
+
+    read_offset = entry.data_offset + entry.data_size;
+    used_size -= entry.occupied_size;
+    total_data_size -= entry.data_size;
+
+    first_entry = (first_entry + 1) & (entries.size() - 1);
+    entry_count--;
+  }
+
+  // Start from the beginning of the buffer once it's empty to avoid skipping its end.
+  if (entry_count == 0) {
+    first_entry = 0;
+    read_offset = 0;
+    write_offset = 0;
+  }
+}
+
+}  // namespace async_net::detail
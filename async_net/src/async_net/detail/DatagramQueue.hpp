@@ -0,0 +1,71 @@
+#pragma once
+#include <async_net/IpAddress.hpp>
+
+#include <base/macro/ClassTraits.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace async_net::detail {
+
+// FIFO of datagrams waiting to be sent. Payloads are kept contiguous in a ring buffer of bytes (the
+// end of the buffer is skipped if a payload doesn't fit there) and described by a ring of entries,
+// so pushing and popping datagrams is O(1). Rings double in size (compacting their contents) only
+// when they are full.
+class DatagramQueue {
+ public:
+  struct Entry {
+    SocketAddress destination;
+    // Non-zero if the kernel splits the datagram into segments of this size (UDP GSO).
+    uint16_t segment_size{};
+    size_t data_offset{};
+    size_t data_size{};
+    // Data size plus the part of the buffer end skipped before the data.
+    size_t occupied_size{};
+  };
+
+ private:
+  std::vector<Entry> entries;
+  size_t first_entry{};
+  size_t entry_count{};
+
+  std::unique_ptr<uint8_t[]> buffer;
+  size_t buffer_capacity{};
+  // Occupied part of the buffer starts at `read_offset` and is `used_size` bytes long (wrapping
+  // around the end). New data is written at `write_offset`.
+  size_t read_offset{};
+  size_t write_offset{};
+  size_t used_size{};
+  size_t total_data_size{};
+
+  bool find_space(size_t size, size_t& offset, size_t& skipped_size) const;
+  void grow_entries();
+  void grow_buffer(size_t required_size);
+
+ public:
+  CLASS_NON_COPYABLE_NON_MOVABLE(DatagramQueue)
+
+  DatagramQueue() = default;
+
+  size_t size() const { return entry_count; }
+  bool empty() const { return entry_count == 0; }
+  // Total size of all queued payloads.
+  size_t data_size() const { return total_data_size; }
+
+  const Entry& operator[](size_t index) const {
+    return entries[(first_entry + index) & (entries.size() - 1)];
+  }
+  std::span<const uint8_t> data(const Entry& entry) const {
+    return {buffer.get() + entry.data_offset, entry.data_size};
+  }
+
+  void push(const SocketAddress& destination,
+            std::span<const uint8_t> data,
+            uint16_t segment_size = 0);
+  void pop(size_t count);
+};
+
+}  // namespace async_net::detail
@@ -1,4 +1,5 @@
 #include "IoContextImpl.hpp"
+#include "TcpConnectionHandoff.hpp"
 #include "TcpConnectionImpl.hpp"
 #include "TcpListenerImpl.hpp"
 #include "UdpSocketImpl.hpp"
@@ -11,6 +12,7 @@
 #include <async_net/TcpConnection.hpp>
 
 #include <algorithm>
+#include <array>
 
 namespace async_net::detail {
 
@@ -22,6 +24,16 @@ static uint64_t round_precise_time_to_ms(base::PreciseTime time) {
   return ms + 1;
 }
 
+// Converts time to wait to the poller timeout in nanoseconds (clamped to what a millisecond
+// timeout can express).
+static int64_t to_poll_timeout_ns(base::PreciseTime time, bool precise) {
+  constexpr uint64_t max_timeout_ms = std::numeric_limits<int>::max();
+  if (precise) {
+    return int64_t(std::min(time.nanoseconds(), max_timeout_ms * 1'000'000));
+  }
+  return int64_t(std::min(round_precise_time_to_ms(time), max_timeout_ms) * 1'000'000);
+}
+
 class ContextEntryRegistration {
  public:
   template <typename T, typename U>
@@ -31,7 +43,12 @@ class ContextEntryRegistration {
   }
 
   template <typename T, typename U>
-  static void unregister_entry(std::vector<T>& entries, U* entry) {
+  static void unregister_entry(std::vector<T>& entries, std::vector<U*>& poll_updates, U* entry) {
+    if (entry->poll_update_pending) {
+      entry->poll_update_pending = false;
+      std::erase(poll_updates, entry);
+    }
+
     if (entry->context_index != invalid_context_index) {
       const auto last_index = entries.size() - 1;
       if (entry->context_index != last_index) {
@@ -42,69 +59,112 @@ class ContextEntryRegistration {
       entries.pop_back();
     }
   }
-};
-
-void IoContextImpl::register_poll_entries() {
-  poll_entries.clear();
 
-  for (const auto& listener : tcp_listeners) {
-    const auto accepts_connections =
-      listener->is_listening() && listener->accept_connections && listener->on_accept;
-
-    poll_entries.emplace_back(sock::Poller::PollEntry{
-      .socket = &listener->socket,
-      .query_events = accepts_connections ? sock::Poller::QueryEvents::CanAccept
-                                          : sock::Poller::QueryEvents::None,
-    });
+  template <typename T>
+  static void queue_poll_update(std::vector<T*>& poll_updates, T* entry) {
+    if (entry->context_index != invalid_context_index && !entry->poll_update_pending) {
+      entry->poll_update_pending = true;
+      poll_updates.push_back(entry);
+    }
   }
+};
 
-  for (const auto& connection : tcp_connections) {
-    auto query_events = sock::Poller::QueryEvents::None;
-    sock::Socket* socket = nullptr;
+void IoContextImpl::update_tcp_listener_poll_entry(TcpListenerImpl& listener) {
+  const auto accepts_connections =
+    listener.is_listening() && listener.accept_connections && listener.has_accept_handler();
 
-    if (connection->connecting_state) {
-      if (connection->state == TcpConnection::State::Connecting) {
-        socket = &connection->connecting_state->socket;
+  listener.poll_entry.user_data = &listener;
+  listener.poll_entry.user_tag = uint32_t(PollEntryOwner::TcpListener);
+  listener.poll_entry.socket = &listener.socket;
+  listener.poll_entry.query_events =
+    accepts_connections ? sock::Poller::QueryEvents::CanAccept : sock::Poller::QueryEvents::None;
+}
 
-        query_events = query_events | sock::Poller::QueryEvents::CanReceiveFrom |
-                       sock::Poller::QueryEvents::CanSendTo;
-      }
-    } else {
-      socket = &connection->socket;
+void IoContextImpl::update_tcp_connection_poll_entry(TcpConnectionImpl& connection) {
+  auto query_events = sock::Poller::QueryEvents::None;
+  sock::Socket* socket = nullptr;
+
+  if (connection.connecting_state) {
+    if (connection.state == TcpConnection::State::Connecting) {
+      socket = &connection.connecting_state->socket;
 
-      if (connection->state == TcpConnection::State::Connected && connection->receive_packets &&
-          connection->on_data_received &&
-          (!connection->block_on_send_buffer_full ||
-           connection->send_buffer_size() < connection->send_buffer_max_size)) {
+      query_events = query_events | sock::Poller::QueryEvents::CanReceiveFrom |
+                     sock::Poller::QueryEvents::CanSendTo;
+    }
+  } else {
+    socket = &connection.socket;
+
+    if (connection.state == TcpConnection::State::Connected && connection.receive_packets) {
+      if (connection.relay_output) {
+        // Relayed data is received only while the pipe has room for it.
+        if (!connection.relay_output->pipe_full) {
+          query_events = query_events | sock::Poller::QueryEvents::CanReceiveFrom;
+        }
+      } else if (connection.on_data_received &&
+                 (!connection.block_on_send_buffer_full ||
+                  connection.send_buffer_size() < connection.send_buffer_max_size)) {
         query_events = query_events | sock::Poller::QueryEvents::CanReceiveFrom;
       }
-      if (connection->can_send_packets && connection->send_buffer_size() > 0) {
-        query_events = query_events | sock::Poller::QueryEvents::CanSendTo;
-      }
     }
+    if (connection.can_send_packets &&
+        (connection.send_buffer_size() > 0 || connection.relay_input_size() > 0)) {
+      query_events = query_events | sock::Poller::QueryEvents::CanSendTo;
+    }
+  }
+
+  connection.poll_entry.user_data = &connection;
+  connection.poll_entry.user_tag = uint32_t(PollEntryOwner::TcpConnection);
+  connection.poll_entry.socket = socket;
+  connection.poll_entry.query_events = query_events;
+}
 
-    poll_entries.emplace_back(sock::Poller::PollEntry{
-      .socket = socket,
-      .query_events = query_events,
-    });
+void IoContextImpl::update_udp_socket_poll_entry(UdpSocketImpl& socket) {
+  auto query_events = sock::Poller::QueryEvents::None;
+  if (socket.state == UdpSocket::State::Bound && socket.receive_packets &&
+      socket.has_receive_callback() &&
+      (!socket.block_on_send_buffer_full || !socket.is_send_buffer_full())) {
+    query_events = query_events | sock::Poller::QueryEvents::CanReceiveFrom;
+  }
+  if (socket.can_send_packets && !socket.send_queue.empty()) {
+    query_events = query_events | sock::Poller::QueryEvents::CanSendTo;
   }
 
-  for (const auto& socket : udp_sockets) {
-    auto query_events = sock::Poller::QueryEvents::None;
-    if (socket->state == UdpSocket::State::Bound && socket->receive_packets &&
-        socket->on_data_received &&
-        (!socket->block_on_send_buffer_full || !socket->is_send_buffer_full())) {
-      query_events = query_events | sock::Poller::QueryEvents::CanReceiveFrom;
-    }
-    if (socket->can_send_packets && !socket->send_entries.empty()) {
-      query_events = query_events | sock::Poller::QueryEvents::CanSendTo;
+  socket.poll_entry.user_data = &socket;
+  socket.poll_entry.user_tag = uint32_t(PollEntryOwner::UdpSocket);
+  socket.poll_entry.socket = &socket.socket;
+  socket.poll_entry.query_events = query_events;
+}
+
+bool IoContextImpl::update_poll_entries() {
+  sock::Status update_status{};
+
+  const auto update_entries = [&]<typename T, typename Fn>(std::vector<T*>& updates, Fn&& update) {
+    for (const auto entry : updates) {
+      entry->poll_update_pending = false;
+
+      update(*entry);
+
+      if (const auto status = poller->update_entry(entry->poll_entry); !status && update_status) {
+        update_status = status;
+      }
     }
+    updates.clear();
+  };
+
+  update_entries(tcp_listener_poll_updates,
+                 [this](TcpListenerImpl& listener) { update_tcp_listener_poll_entry(listener); });
+  update_entries(tcp_connection_poll_updates, [this](TcpConnectionImpl& connection) {
+    update_tcp_connection_poll_entry(connection);
+  });
+  update_entries(udp_socket_poll_updates,
+                 [this](UdpSocketImpl& socket) { update_udp_socket_poll_entry(socket); });
 
-    poll_entries.emplace_back(sock::Poller::PollEntry{
-      .socket = &socket->socket,
-      .query_events = query_events,
-    });
+  if (!update_status) {
+    log_error("failed to update poll entries: {}", update_status.stringify());
+    return false;
   }
+
+  return true;
 }
 
 void IoContextImpl::handle_tcp_listener_events(const sock::Poller::PollEntry& entry,
@@ -137,20 +197,33 @@ void IoContextImpl::handle_tcp_listener_events(const sock::Poller::PollEntry& en
   }
 
   if (entry.has_events(sock::Poller::StatusEvents::CanAccept)) {
-    while (listener->is_listening() && listener->accept_connections && listener->on_accept) {
+    const auto report_accept_error = [&](const Status& status) {
+      if (listener->on_accept) {
+        listener->on_accept(status, TcpConnection{});
+      } else {
+        log_error("failed to accept TCP connection: {}", status.stringify());
+      }
+    };
+
+    while (listener->is_listening() && listener->accept_connections &&
+           listener->has_accept_handler()) {
       auto [accept_status, client_socket] = listener->socket.accept();
       if (!accept_status) {
         if (!accept_status.would_block()) {
-          listener->on_accept(accept_status, TcpConnection{});
+          report_accept_error(accept_status);
         }
         break;
       }
 
-      if (const auto status = client_socket.set_non_blocking(true)) {
+      add_to_stat_counter(stat_counters.accepted_connections, 1);
+
+      if (const auto status = client_socket.set_non_blocking(true); !status) {
+        report_accept_error(status);
+      } else if (const auto handoff = listener->handoff) {
+        handoff->hand_off(handoff, std::move(client_socket));
+      } else {
         TcpConnection connection{listener->context, std::move(client_socket)};
         listener->on_accept(Status{}, std::move(connection));
-      } else {
-        listener->on_accept(status, TcpConnection{});
       }
     }
   }
@@ -216,10 +289,6 @@ IoContextImpl::PendingConnectionStatus IoContextImpl::handle_tcp_pending_connect
 void IoContextImpl::handle_tcp_connection_events(
   const sock::Poller::PollEntry& entry,
   const std::shared_ptr<TcpConnectionImpl>& connection) {
-  constexpr static size_t base_receive_fragment_size = 16 * 1024;
-  constexpr static size_t max_receive_fragment_size = 16 * 1024 * 1024;
-  constexpr static size_t max_send_fragment_size = 32 * 1024 * 1024;
-
   if (connection->connecting_state) {
     const auto status = handle_tcp_pending_connection_events(entry, connection);
     if (status == PendingConnectionStatus::Failed) {
@@ -253,25 +322,51 @@ void IoContextImpl::handle_tcp_connection_events(
     connection->unregister_during_runloop(connection);
   };
 
+  // Zero-copy completions are queued on the socket error queue which pollers report as an error.
+  // A real error keeps the socket signaled, so it's handled once no completions are left.
+  bool zero_copy_completed = false;
+  if (connection->zero_copy_enabled && entry.has_events(sock::Poller::StatusEvents::Error)) {
+    zero_copy_completed = connection->process_zero_copy_completions() > 0;
+
+    if (!connection->has_pending_sends() && connection->state != TcpConnection::State::Connected) {
+      connection->unregister_during_runloop(connection);
+    }
+  }
+
   if (entry.has_events(sock::Poller::StatusEvents::CanReceiveFrom) &&
       connection->state == TcpConnection::State::Connected && connection->receive_packets &&
-      connection->on_data_received) {
+      connection->relay_output) {
+    if (const auto receive_error = connection->receive_relayed_data(); !receive_error) {
+      on_socket_error(receive_error);
+    }
+  } else if (entry.has_events(sock::Poller::StatusEvents::CanReceiveFrom) &&
+             connection->state == TcpConnection::State::Connected &&
+             connection->receive_packets && connection->on_data_received) {
     sock::Status receive_error = {};
     size_t total_bytes_received = 0;
 
-    while (total_bytes_received < max_receive_fragment_size) {
+    // Most handlers consume everything they are given, so receive into the scratch buffer shared
+    // by all connections and only keep the unconsumed tail in the connection's own buffer. Data
+    // which is already buffered must stay in front of the new data so it's received in place.
+    const auto use_scratch_buffer = connection->receive_buffer.empty();
+    auto& receive_buffer =
+      use_scratch_buffer ? tcp_receive_scratch_buffer : connection->receive_buffer;
+
+    // Data left after using up the budget keeps the socket readable so it's received in the next
+    // iteration.
+    while (total_bytes_received < connection->receive_budget) {
       const auto available_buffer_size =
-        std::max(base_receive_fragment_size, connection->receive_buffer.unused_capacity());
-      const auto size_left_to_receive = max_receive_fragment_size - total_bytes_received;
+        std::max(connection->receive_fragment_size, receive_buffer.unused_capacity());
+      const auto size_left_to_receive = connection->receive_budget - total_bytes_received;
       const auto max_receive_amount = std::min(size_left_to_receive, available_buffer_size);
 
-      const auto previous_size = connection->receive_buffer.size();
-      const auto current_receive_buffer = connection->receive_buffer.grow(max_receive_amount);
+      const auto previous_size = receive_buffer.size();
+      const auto current_receive_buffer = receive_buffer.grow(max_receive_amount);
 
       const auto [receive_status, bytes_received] =
         connection->socket.receive(current_receive_buffer);
 
-      connection->receive_buffer.resize(previous_size + bytes_received);
+      receive_buffer.resize(previous_size + bytes_received);
 
       if (!receive_status) {
         if (!receive_status.would_block()) {
@@ -290,11 +385,31 @@ void IoContextImpl::handle_tcp_connection_events(
 
     if (total_bytes_received > 0) {
       connection->total_bytes_received += total_bytes_received;
+      connection->update_receive_fragment_size(total_bytes_received);
+
+      connection->dispatching_received_data = true;
+      if (use_scratch_buffer) {
+        const auto consumed_bytes = connection->on_data_received(receive_buffer.span());
+        verify(consumed_bytes <= receive_buffer.size(), "consumed more data than was received");
+
+        connection->receive_buffer.append(receive_buffer.span().subspan(consumed_bytes));
+      } else {
+        const auto consumed_bytes =
+          connection->on_data_received(connection->pending_received_data());
+        connection->consume_received_data(consumed_bytes);
+      }
+      connection->dispatching_received_data = false;
 
-      const auto consumed_bytes = connection->on_data_received(connection->receive_buffer.span());
-      if (consumed_bytes > 0) {
-        connection->receive_buffer.trim_front(consumed_bytes);
+      // The handler might have started relaying the connection.
+      if (connection->relay_output) {
+        connection->relay_pending_received_data();
       }
+
+      connection->shrink_receive_buffer();
+    }
+
+    if (use_scratch_buffer) {
+      tcp_receive_scratch_buffer.clear();
     }
 
     if (!receive_error) {
@@ -303,8 +418,8 @@ void IoContextImpl::handle_tcp_connection_events(
   }
 
   if (entry.has_any_event(sock::Poller::StatusEvents::InvalidSocket |
-                          sock::Poller::StatusEvents::Error |
-                          sock::Poller::StatusEvents::Disconnected)) {
+                          sock::Poller::StatusEvents::Disconnected) ||
+      (entry.has_events(sock::Poller::StatusEvents::Error) && !zero_copy_completed)) {
     if (connection->state == TcpConnection::State::Connected) {
       auto error = connection->socket.last_error();
       if (error == SystemError::None) {
@@ -324,45 +439,18 @@ void IoContextImpl::handle_tcp_connection_events(
   }
 
   if (entry.has_events(sock::Poller::StatusEvents::CanSendTo) && connection->can_send_packets) {
-    const std::span<const uint8_t> initial_send_buffer =
-      connection->send_buffer.span().subspan(connection->send_buffer_offset);
-
-    auto send_buffer = initial_send_buffer;
-
-    while (!send_buffer.empty()) {
-      auto current_send_buffer = send_buffer;
-      if (current_send_buffer.size() > max_send_fragment_size) {
-        current_send_buffer = current_send_buffer.subspan(0, max_send_fragment_size);
-      }
-
-      const auto [send_status, bytes_sent] = connection->socket.send(current_send_buffer);
-      if (!send_status) {
-        if (!send_status.would_block()) {
-          on_socket_error(send_status);
-        }
-
-        break;
-      }
-
-      send_buffer = send_buffer.subspan(bytes_sent);
-
-      if (bytes_sent < current_send_buffer.size()) {
-        break;
-      }
+    const auto [send_status, bytes_sent] = connection->send_buffered_data();
+    if (!send_status) {
+      on_socket_error(send_status);
     }
 
-    const auto total_bytes_sent = initial_send_buffer.size() - send_buffer.size();
-
-    if (total_bytes_sent > 0) {
-      connection->total_bytes_sent += total_bytes_sent;
-      connection->send_buffer_offset += total_bytes_sent;
-
+    if (bytes_sent > 0) {
       if (connection->state == TcpConnection::State::Connected && connection->on_data_sent) {
         connection->on_data_sent();
       }
     }
 
-    if (connection->send_buffer_size() == 0 &&
+    if (!connection->has_pending_sends() &&
         connection->state != TcpConnection::State::Connected) {
       connection->unregister_during_runloop(connection);
     }
@@ -387,12 +475,18 @@ void IoContextImpl::handle_udp_socket_events(const sock::Poller::PollEntry& entr
   };
 
   if (entry.has_events(sock::Poller::StatusEvents::CanReceiveFrom)) {
-    SocketAddress peer_address;
+    size_t datagrams_received = 0;
+
+    while (datagrams_received < socket->receive_budget) {
+      if (socket->state != UdpSocket::State::Bound || !socket->receive_packets ||
+          !socket->has_receive_callback()) {
+        break;
+      }
 
-    while (socket->state == UdpSocket::State::Bound && socket->receive_packets &&
-           socket->on_data_received) {
-      const auto [status, bytes_received] =
-        socket->socket.receive_from(peer_address, udp_receive_buffer);
+      const auto slot_count =
+        std::min(socket->receive_budget - datagrams_received, udp_receive_slots.size());
+      const auto [status, received_count] =
+        socket->socket.receive_many(std::span(udp_receive_slots).subspan(0, slot_count));
       if (!status) {
         if (!status.would_block()) {
           on_socket_error(status);
@@ -400,8 +494,61 @@ void IoContextImpl::handle_udp_socket_events(const sock::Poller::PollEntry& entr
         break;
       }
 
-      socket->total_bytes_received += bytes_received;
-      socket->on_data_received(peer_address, udp_receive_buffer.span().subspan(0, bytes_received));
+      bool coalesced = false;
+      for (size_t i = 0; i < received_count; ++i) {
+        const auto& slot = udp_receive_slots[i];
+        udp_received_datagrams[i].data = slot.data.subspan(0, slot.size);
+        socket->total_bytes_received += slot.size;
+        coalesced |= slot.segment_size > 0 && slot.size > slot.segment_size;
+      }
+
+      auto datagrams = std::span(udp_received_datagrams).subspan(0, received_count);
+
+      // Split datagrams coalesced by the kernel (UDP GRO) so the callbacks see them separately.
+      if (coalesced) {
+        udp_split_datagrams.clear();
+
+        for (size_t i = 0; i < received_count; ++i) {
+          const auto& datagram = udp_received_datagrams[i];
+          const auto segment_size = udp_receive_slots[i].segment_size;
+          if (segment_size == 0) {
+            udp_split_datagrams.push_back(datagram);
+            continue;
+          }
+
+          for (size_t offset = 0; offset < datagram.data.size(); offset += segment_size) {
+            udp_split_datagrams.push_back({
+              .peer = datagram.peer,
+              .data = datagram.data.subspan(offset,
+                                            std::min(segment_size, datagram.data.size() - offset)),
+            });
+          }
+        }
+
+        datagrams = udp_split_datagrams;
+      }
+      datagrams_received += datagrams.size();
+
+      bool stop_receiving = false;
+      if (socket->on_batch_received) {
+        socket->on_batch_received(datagrams);
+      } else {
+        for (const auto& datagram : datagrams) {
+          // A callback might have shut the socket down or paused receiving, the rest of the batch
+          // is dropped then.
+          if (socket->state != UdpSocket::State::Bound || !socket->receive_packets ||
+              !socket->on_data_received) {
+            stop_receiving = true;
+            break;
+          }
+          socket->on_data_received(datagram.peer, datagram.data);
+        }
+      }
+
+      // Stop if delivery was stopped or no more datagrams are waiting.
+      if (stop_receiving || received_count < slot_count) {
+        break;
+      }
     }
   }
 
@@ -424,74 +571,183 @@ void IoContextImpl::handle_udp_socket_events(const sock::Poller::PollEntry& entr
   }
 
   if (entry.has_events(sock::Poller::StatusEvents::CanSendTo) && socket->can_send_packets) {
-    size_t total_bytes_sent = 0;
-    size_t send_entries_processed = 0;
+    send_udp_datagrams(socket);
+  }
+}
 
-    // This vector can be modified (items inserted) in the callback so we need to watch out.
-    for (size_t i = 0; i < socket->send_entries.size(); ++i) {
-      const auto send_entry = socket->send_entries[i];
+void IoContextImpl::send_udp_datagrams(const std::shared_ptr<UdpSocketImpl>& socket) {
+  std::array<sock::DatagramSocket::SendSlot, udp_send_batch_size> send_slots;
+
+  size_t total_bytes_sent = 0;
+  size_t datagrams_processed = 0;
+  const auto send_budget = socket->remaining_send_budget();
+
+  // Datagrams can be queued in the callbacks (which may move the queued data), so processed ones
+  // are popped and the slots are filled again before every call.
+  while (socket->can_send_packets && datagrams_processed < send_budget &&
+         !socket->send_queue.empty()) {
+    const auto slot_count = std::min(
+      {send_slots.size(), send_budget - datagrams_processed, socket->send_queue.size()});
+
+    for (size_t i = 0; i < slot_count; ++i) {
+      const auto& datagram = socket->send_queue[i];
+      send_slots[i] = {
+        .data = socket->send_queue.data(datagram),
+        .to = &datagram.destination,
+        .segment_size = datagram.segment_size,
+      };
+    }
 
-      const auto send_data =
-        socket->send_buffer.span().subspan(socket->send_buffer_offset, send_entry.datagram_size);
-      const auto [status, bytes_sent] = socket->socket.send_to(send_entry.destination, send_data);
-      if (status.would_block()) {
-        break;
-      }
+    const auto [status, sent_count] =
+      socket->socket.send_many(std::span(send_slots).subspan(0, slot_count));
+    if (status.would_block()) {
+      break;
+    }
 
-      socket->send_buffer_offset += send_data.size();
-      send_entries_processed++;
+    // The first datagram has failed, it's dropped like the ones which were sent.
+    if (!status) {
+      socket->send_queue.pop(1);
+      datagrams_processed++;
 
-      if (status) {
-        total_bytes_sent += bytes_sent;
+      if (socket->on_send_error) {
+        socket->on_send_error(status);
       }
+      continue;
+    }
 
-      if (socket->on_send_error) {
-        if (!status) {
-          socket->on_send_error(status);
-        } else if (bytes_sent < send_entry.datagram_size) {
-          socket->on_send_error({
-            .error = sock::Error::SizeTooLarge,
-          });
-        }
+    socket->send_queue.pop(sent_count);
+    datagrams_processed += sent_count;
+
+    for (size_t i = 0; i < sent_count; ++i) {
+      const auto bytes_sent = send_slots[i].size;
+      total_bytes_sent += bytes_sent;
+
+      if (socket->on_send_error && bytes_sent < send_slots[i].data.size()) {
+        socket->on_send_error({
+          .error = sock::Error::SizeTooLarge,
+        });
       }
     }
+  }
+
+  socket->iteration_datagrams_sent += datagrams_processed;
 
-    if (send_entries_processed > 0) {
-      socket->send_entries.erase(socket->send_entries.begin(),
-                                 socket->send_entries.begin() + ptrdiff_t(send_entries_processed));
+  if (total_bytes_sent > 0) {
+    socket->total_bytes_sent += total_bytes_sent;
+
+    if (socket->state == UdpSocket::State::Bound && socket->on_data_sent) {
+      socket->on_data_sent();
     }
+  }
 
-    if (total_bytes_sent > 0) {
-      socket->total_bytes_sent += total_bytes_sent;
+  if (socket->send_queue.empty() && socket->state != UdpSocket::State::Bound) {
+    socket->unregister_during_runloop(socket);
+  }
+}
 
-      if (socket->state == UdpSocket::State::Bound && socket->on_data_sent) {
-        socket->on_data_sent();
+void IoContextImpl::collect_signaled_entries() {
+  // Signaled entries are registered so their owners are always in the registries. Keep them alive
+  // while dispatching as handlers can unregister (and destroy) other entries.
+  for (const auto entry : poller->signaled_entries()) {
+    switch (PollEntryOwner(entry->user_tag)) {
+      case PollEntryOwner::TcpListener: {
+        const auto listener = static_cast<TcpListenerImpl*>(entry->user_data);
+        signaled_tcp_listeners.push_back(tcp_listeners[listener->context_index]);
+        break;
       }
+      case PollEntryOwner::TcpConnection: {
+        const auto connection = static_cast<TcpConnectionImpl*>(entry->user_data);
+        signaled_tcp_connections.push_back(tcp_connections[connection->context_index]);
+        break;
+      }
+      case PollEntryOwner::UdpSocket: {
+        const auto socket = static_cast<UdpSocketImpl*>(entry->user_data);
+        signaled_udp_sockets.push_back(udp_sockets[socket->context_index]);
+        break;
+      }
+    }
+  }
+}
+
+void IoContextImpl::handle_poll_events() {
+  collect_signaled_entries();
+
+  // Handlers can remove the poll entry (which clears its status) so they get a copy. Entries
+  // removed by previous handlers have no status events left and are skipped.
+  for (const auto& listener : signaled_tcp_listeners) {
+    if (const auto entry = listener->poll_entry;
+        entry.status_events != sock::Poller::StatusEvents::None) {
+      handle_tcp_listener_events(entry, listener);
+      queue_poll_update(listener.get());
     }
+  }
 
-    if (socket->send_entries.empty() && socket->state != UdpSocket::State::Bound) {
-      socket->unregister_during_runloop(socket);
+  for (const auto& connection : signaled_tcp_connections) {
+    if (const auto entry = connection->poll_entry;
+        entry.status_events != sock::Poller::StatusEvents::None) {
+      handle_tcp_connection_events(entry, connection);
+      queue_poll_update(connection.get());
+    }
+  }
+
+  for (const auto& socket : signaled_udp_sockets) {
+    if (const auto entry = socket->poll_entry;
+        entry.status_events != sock::Poller::StatusEvents::None) {
+      handle_udp_socket_events(entry, socket);
+      queue_poll_update(socket.get());
     }
   }
+
+  signaled_tcp_listeners.clear();
+  signaled_tcp_connections.clear();
+  signaled_udp_sockets.clear();
 }
 
-void IoContextImpl::handle_poll_events() {
-  size_t entry_index = 0;
+void IoContextImpl::flush_tcp_connections() {
+  std::swap(tcp_connection_flushes, tcp_connection_flushes_read);
+
+  for (const auto& connection : tcp_connection_flushes_read) {
+    connection->flush_pending = false;
+
+    if (connection->state != TcpConnection::State::Connected || !connection->can_send_packets ||
+        connection->send_blocked) {
+      continue;
+    }
 
-  for (size_t i = 0; i < tcp_listeners.size(); ++i) {
-    handle_tcp_listener_events(poll_entries[entry_index + i], tcp_listeners[i]);
+    // Errors will be reported by the poller.
+    const auto [send_status, bytes_sent] = connection->send_buffered_data();
+    if (bytes_sent > 0 && connection->on_data_sent) {
+      connection->on_data_sent();
+    }
   }
-  entry_index += tcp_listeners.size();
+  tcp_connection_flushes_read.clear();
+}
+
+void IoContextImpl::flush_udp_sockets() {
+  std::swap(udp_socket_flushes, udp_socket_flushes_read);
 
-  for (size_t i = 0; i < tcp_connections.size(); ++i) {
-    handle_tcp_connection_events(poll_entries[entry_index + i], tcp_connections[i]);
+  for (const auto& socket : udp_socket_flushes_read) {
+    socket->flush_pending = false;
+
+    if (socket->can_send_packets && !socket->send_queue.empty()) {
+      send_udp_datagrams(socket);
+    }
   }
-  entry_index += tcp_connections.size();
+  udp_socket_flushes_read.clear();
+}
 
-  for (size_t i = 0; i < udp_sockets.size(); ++i) {
-    handle_udp_socket_events(poll_entries[entry_index + i], udp_sockets[i]);
+void IoContextImpl::release_idle_buffers(base::PreciseTime now) {
+  if (!idle_buffer_release_after || now < next_idle_buffer_sweep) {
+    return;
+  }
+
+  // Connections which didn't receive anything since the previous sweep have been idle for at least
+  // one full period.
+  for (const auto& connection : tcp_connections) {
+    connection->release_idle_buffers();
   }
-  entry_index += udp_sockets.size();
+
+  next_idle_buffer_sweep = now + *idle_buffer_release_after;
 }
 
 void IoContextImpl::run_deferred_work() {
@@ -506,47 +762,50 @@ void IoContextImpl::run_deferred_work() {
 }
 
 void IoContextImpl::run_deferred_work_atomic() {
-  {
-    std::lock_guard lock(deferred_work_atomic_mutex);
-    std::swap(deferred_work_atomic_read, deferred_work_atomic_write);
-  }
-
-  for (auto& callback : deferred_work_atomic_read) {
-    callback();
-  }
-  deferred_work_atomic_read.clear();
+  deferred_work_atomic.consume_all([](Task callback) { callback(); });
 }
 
 void IoContextImpl::drain_tcp_listeners() {
   for (auto& listener : tcp_listeners) {
+    remove_poll_entry(listener->poll_entry);
+    listener->poll_update_pending = false;
     listener->state = TcpListener::State::Shutdown;
     listener->context_index = invalid_context_index;
   }
 
   std::vector<std::shared_ptr<TcpListenerImpl>> temp;
   std::swap(temp, tcp_listeners);
+  tcp_listener_poll_updates.clear();
   temp.clear();
 }
 
 void IoContextImpl::drain_tcp_connections() {
   for (auto& connection : tcp_connections) {
+    remove_poll_entry(connection->poll_entry);
+    connection->poll_update_pending = false;
     connection->state = TcpConnection::State::Shutdown;
     connection->context_index = invalid_context_index;
   }
 
   std::vector<std::shared_ptr<TcpConnectionImpl>> temp;
   std::swap(temp, tcp_connections);
+  tcp_connection_poll_updates.clear();
+  tcp_connection_flushes.clear();
   temp.clear();
 }
 
 void IoContextImpl::drain_udp_sockets() {
   for (auto& socket : udp_sockets) {
+    remove_poll_entry(socket->poll_entry);
+    socket->poll_update_pending = false;
     socket->state = UdpSocket::State::Shutdown;
     socket->context_index = invalid_context_index;
   }
 
   std::vector<std::shared_ptr<UdpSocketImpl>> temp;
   std::swap(temp, udp_sockets);
+  udp_socket_poll_updates.clear();
+  udp_socket_flushes.clear();
   temp.clear();
 }
 
@@ -558,12 +817,7 @@ void IoContextImpl::drain_deferred_work() {
 }
 
 void IoContextImpl::drain_deferred_work_atomic() {
-  {
-    std::lock_guard lock(deferred_work_atomic_mutex);
-    std::swap(deferred_work_atomic_read, deferred_work_atomic_write);
-  }
-
-  deferred_work_atomic_read.clear();
+  deferred_work_atomic.consume_all([](Task) {});
 }
 
 bool IoContextImpl::has_any_non_atomic_work() const {
@@ -571,50 +825,144 @@ bool IoContextImpl::has_any_non_atomic_work() const {
            deferred_work_write.empty() && timer_manager.empty() && ip_resolver.empty());
 }
 
-IoContextImpl::IoContextImpl() : ip_resolver(*this) {
+IoContextImpl::IoContextImpl(const IoContext::CreateParameters& parameters)
+    : precise_timers(parameters.precise_timers),
+      budgets(parameters.io_budgets),
+      idle_buffer_release_after(parameters.idle_buffer_release_after),
+      ip_resolver(*this) {
+  verify(budgets.tcp_receive_bytes > 0 && budgets.tcp_send_bytes > 0 &&
+           budgets.udp_receive_datagrams > 0 && budgets.udp_send_datagrams > 0,
+         "IO budgets must be non-zero");
+
   poller = sock::Poller::create({
     .enable_cancellation = true,
   });
   verify(poller, "failed to create socket poller");
+
+  if (idle_buffer_release_after) {
+    next_idle_buffer_sweep = base::PreciseTime::now() + *idle_buffer_release_after;
+  }
+}
+
+IoContext::Stats IoContextImpl::stats() const {
+  return {
+    .iterations = stat_counters.iterations.load(std::memory_order_relaxed),
+    .signaled_entries = stat_counters.signaled_entries.load(std::memory_order_relaxed),
+    .accepted_connections = stat_counters.accepted_connections.load(std::memory_order_relaxed),
+    .tcp_connections = stat_counters.tcp_connections.load(std::memory_order_relaxed),
+    .wakeups = stat_counters.wakeups.load(std::memory_order_relaxed),
+    .poll_wait_time = base::PreciseTime::from_nanoseconds(
+      stat_counters.poll_wait_time_ns.load(std::memory_order_relaxed)),
+  };
 }
 
 void IoContextImpl::register_tcp_listener(std::shared_ptr<TcpListenerImpl> listener) {
+  const auto entry = listener.get();
   ContextEntryRegistration::register_entry(tcp_listeners, std::move(listener));
+  queue_poll_update(entry);
 }
 
 void IoContextImpl::unregister_tcp_listener(TcpListenerImpl* listener) {
-  ContextEntryRegistration::unregister_entry(tcp_listeners, listener);
+  remove_poll_entry(listener->poll_entry);
+  ContextEntryRegistration::unregister_entry(tcp_listeners, tcp_listener_poll_updates, listener);
 }
 
 void IoContextImpl::register_tcp_connection(std::shared_ptr<TcpConnectionImpl> connection) {
+  const auto entry = connection.get();
   ContextEntryRegistration::register_entry(tcp_connections, std::move(connection));
+  queue_poll_update(entry);
+
+  stat_counters.tcp_connections.store(tcp_connections.size(), std::memory_order_relaxed);
 }
 
 void IoContextImpl::unregister_tcp_connection(TcpConnectionImpl* connection) {
-  ContextEntryRegistration::unregister_entry(tcp_connections, connection);
+  remove_poll_entry(connection->poll_entry);
+  ContextEntryRegistration::unregister_entry(tcp_connections, tcp_connection_poll_updates,
+                                             connection);
+
+  stat_counters.tcp_connections.store(tcp_connections.size(), std::memory_order_relaxed);
 }
 
 void IoContextImpl::register_udp_socket(std::shared_ptr<UdpSocketImpl> socket) {
+  const auto entry = socket.get();
   ContextEntryRegistration::register_entry(udp_sockets, std::move(socket));
-  if (udp_receive_buffer.empty()) {
-    udp_receive_buffer.resize(max_datagram_size);
+  queue_poll_update(entry);
+  if (!udp_receive_buffer) {
+    udp_receive_buffer =
+      std::make_unique_for_overwrite<uint8_t[]>(udp_receive_batch_size * max_datagram_size);
+    udp_receive_slots.resize(udp_receive_batch_size);
+    udp_received_datagrams.resize(udp_receive_batch_size);
+
+    for (size_t i = 0; i < udp_receive_batch_size; ++i) {
+      udp_receive_slots[i] = {
+        .data = std::span(udp_receive_buffer.get() + i * max_datagram_size, max_datagram_size),
+        .from = &udp_received_datagrams[i].peer,
+      };
+    }
   }
 }
 
 void IoContextImpl::unregister_udp_socket(UdpSocketImpl* socket) {
-  ContextEntryRegistration::unregister_entry(udp_sockets, socket);
+  remove_poll_entry(socket->poll_entry);
+  ContextEntryRegistration::unregister_entry(udp_sockets, udp_socket_poll_updates, socket);
 }
 
-void IoContextImpl::queue_deferred_work(std::move_only_function<void()> callback) {
+void IoContextImpl::queue_poll_update(TcpListenerImpl* listener) {
+  ContextEntryRegistration::queue_poll_update(tcp_listener_poll_updates, listener);
+}
+
+void IoContextImpl::queue_poll_update(TcpConnectionImpl* connection) {
+  ContextEntryRegistration::queue_poll_update(tcp_connection_poll_updates, connection);
+}
+
+void IoContextImpl::queue_poll_update(UdpSocketImpl* socket) {
+  ContextEntryRegistration::queue_poll_update(udp_socket_poll_updates, socket);
+}
+
+void IoContextImpl::queue_data_sent_notification(TcpConnectionImpl* connection) {
+  if (connection->data_sent_notification_pending ||
+      connection->context_index == invalid_context_index) {
+    return;
+  }
+  connection->data_sent_notification_pending = true;
+
+  // Called from inside `TcpConnection::send`, so the callback can't be invoked immediately.
+  queue_deferred_work([connection = tcp_connections[connection->context_index]] {
+    connection->data_sent_notification_pending = false;
+    if (connection->state == TcpConnection::State::Connected && connection->on_data_sent) {
+      connection->on_data_sent();
+    }
+  });
+}
+
+void IoContextImpl::queue_tcp_connection_flush(TcpConnectionImpl* connection) {
+  if (!connection->flush_pending && connection->context_index != invalid_context_index) {
+    connection->flush_pending = true;
+    tcp_connection_flushes.push_back(tcp_connections[connection->context_index]);
+  }
+}
+
+void IoContextImpl::queue_udp_socket_flush(UdpSocketImpl* socket) {
+  if (!socket->flush_pending && socket->context_index != invalid_context_index) {
+    socket->flush_pending = true;
+    udp_socket_flushes.push_back(udp_sockets[socket->context_index]);
+  }
+}
+
+void IoContextImpl::remove_poll_entry(sock::Poller::PollEntry& entry) {
+  if (const auto status = poller->remove_entry(entry); !status) {
+    log_error("failed to remove poll entry: {}", status.stringify());
+  }
+}
+
+void IoContextImpl::queue_deferred_work(Task callback) {
   deferred_work_write.push_back(std::move(callback));
 }
 
-void IoContextImpl::queue_deferred_work_atomic(std::move_only_function<void()> callback) {
-  {
-    std::lock_guard lock(deferred_work_atomic_mutex);
-    deferred_work_atomic_write.push_back(std::move(callback));
+void IoContextImpl::queue_deferred_work_atomic(Task callback) {
+  if (deferred_work_atomic.push(std::move(callback))) {
+    wake_up();
   }
-  notify();
 }
 
 void IoContextImpl::queue_ip_resolve(
@@ -624,7 +972,7 @@ void IoContextImpl::queue_ip_resolve(
 }
 
 TimerManagerImpl::TimerKey IoContextImpl::register_timer(base::PreciseTime deadline,
-                                                         std::move_only_function<void()> callback) {
+                                                         Task callback) {
   return timer_manager.register_timer(deadline, std::move(callback));
 }
 
@@ -639,33 +987,32 @@ void IoContextImpl::unregister_timer(const TimerManagerImpl::TimerKey& key) {
 IoContext::RunResult IoContextImpl::run(const IoContext::RunParameters& parameters) {
   const auto now = base::PreciseTime::now();
 
-  // Make sure all deferred work is done before we block on poll().
-  while (!deferred_work_write.empty() || timer_manager.pending(now)) {
+  iteration++;
+
+  // Make sure all deferred work is done (and corked data is sent) before we block on poll().
+  while (!deferred_work_write.empty() || timer_manager.pending(now) ||
+         !tcp_connection_flushes.empty() || !udp_socket_flushes.empty()) {
     run_deferred_work();
     timer_manager.poll(now);
+    flush_tcp_connections();
+    flush_udp_sockets();
   }
 
-  int timeout_ms = -1;
+  int64_t timeout_ns = -1;
   {
     if (parameters.timeout) {
-      timeout_ms = int(std::min(round_precise_time_to_ms(*parameters.timeout),
-                                uint64_t(std::numeric_limits<int>::max())));
+      timeout_ns = to_poll_timeout_ns(*parameters.timeout, precise_timers);
     }
 
     if (const auto timer_deadline = timer_manager.earliest_deadline()) {
       const auto time_to_deadline = *timer_deadline - now;
       verify(!time_to_deadline.is_zero(), "earliest timer has already expired");
 
-      const auto time_to_deadline_ms = round_precise_time_to_ms(time_to_deadline);
-      const int time_to_deadline_ms_clamped =
-        time_to_deadline_ms > uint64_t(std::numeric_limits<int>::max())
-          ? std::numeric_limits<int>::max()
-          : int(time_to_deadline_ms);
-
-      if (timeout_ms < 0) {
-        timeout_ms = time_to_deadline_ms_clamped;
-      } else if (timeout_ms > 0) {
-        timeout_ms = std::min(timeout_ms, time_to_deadline_ms_clamped);
+      const auto time_to_deadline_ns = to_poll_timeout_ns(time_to_deadline, precise_timers);
+      if (timeout_ns < 0) {
+        timeout_ns = time_to_deadline_ns;
+      } else if (timeout_ns > 0) {
+        timeout_ns = std::min(timeout_ns, time_to_deadline_ns);
       }
     }
 
@@ -674,14 +1021,35 @@ IoContext::RunResult IoContextImpl::run(const IoContext::RunParameters& paramete
     }
   }
 
-  register_poll_entries();
+  if (!update_poll_entries()) {
+    return IoContext::RunResult::Failed;
+  }
+
+  // Pairs with `wake_up`: either we see the pending wakeup here or the waking thread sees that we
+  // are sleeping and interrupts the poll.
+  sleeping_in_poll.store(true);
+  if (wakeup_pending.load()) {
+    timeout_ns = 0;
+  }
+
+  const auto poll_start_time = base::PreciseTime::now();
+  const auto [poll_status, signaled_entries] = poller->poll_registered(timeout_ns);
+  const auto poll_end_time = base::PreciseTime::now();
+
+  sleeping_in_poll.store(false, std::memory_order_relaxed);
+  // Work published before this point is handled below in this iteration.
+  wakeup_pending.exchange(false);
 
-  const auto [poll_status, signaled_entries] = poller->poll(poll_entries, timeout_ms);
   if (!poll_status) {
     log_error("poll failed with result: {}", poll_status.stringify());
     return IoContext::RunResult::Failed;
   }
 
+  add_to_stat_counter(stat_counters.iterations, 1);
+  add_to_stat_counter(stat_counters.signaled_entries, signaled_entries);
+  add_to_stat_counter(stat_counters.poll_wait_time_ns,
+                      (poll_end_time - poll_start_time).nanoseconds());
+
   if (signaled_entries > 0) {
     handle_poll_events();
   }
@@ -689,8 +1057,18 @@ IoContext::RunResult IoContextImpl::run(const IoContext::RunParameters& paramete
   ip_resolver.poll();
   run_deferred_work_atomic();
 
+  if (precise_timers) {
+    // Don't wait for the next `run` call to handle timers that have expired during the poll.
+    timer_manager.poll(poll_end_time);
+  }
+
   run_deferred_work();
 
+  flush_tcp_connections();
+  flush_udp_sockets();
+
+  release_idle_buffers(poll_end_time);
+
   return IoContext::RunResult::Ok;
 }
 
@@ -698,6 +1076,14 @@ void IoContextImpl::notify() {
   verify(poller->cancel(), "failed to cancel IO context run");
 }
 
+void IoContextImpl::wake_up() {
+  wakeup_pending.store(true);
+  if (sleeping_in_poll.load()) {
+    stat_counters.wakeups.fetch_add(1, std::memory_order_relaxed);
+    notify();
+  }
+}
+
 void IoContextImpl::drain() {
   ip_resolver.exit();
   drain_deferred_work_atomic();
@@ -1,12 +1,15 @@
 #pragma once
 #include "IpResolverImpl.hpp"
+#include "MpscQueue.hpp"
 #include "TimerManagerImpl.hpp"
 
 #include <async_net/IoContext.hpp>
+#include <async_net/UdpSocket.hpp>
 
+#include <atomic>
 #include <functional>
 #include <memory>
-#include <mutex>
+#include <optional>
 #include <vector>
 
 #include <socklib/Socket.hpp>
@@ -25,20 +28,69 @@ class IoContextImpl {
   std::vector<std::shared_ptr<TcpConnectionImpl>> tcp_connections;
   std::vector<std::shared_ptr<UdpSocketImpl>> udp_sockets;
 
-  base::BinaryBuffer udp_receive_buffer;
+  // Arena with `udp_receive_batch_size` slots of `max_datagram_size` bytes. It's left
+  // uninitialized, so the allocator maps it lazily and only pages written by the kernel get backed
+  // by memory. Receive slots write the senders' addresses straight into the matching received
+  // datagrams.
+  std::unique_ptr<uint8_t[]> udp_receive_buffer;
+  std::vector<sock::DatagramSocket::ReceiveSlot> udp_receive_slots;
+  std::vector<UdpSocket::ReceivedDatagram> udp_received_datagrams;
+  std::vector<UdpSocket::ReceivedDatagram> udp_split_datagrams;
+  base::BinaryBuffer tcp_receive_scratch_buffer;
 
   std::unique_ptr<sock::Poller> poller;
-  std::vector<sock::Poller::PollEntry> poll_entries;
+  bool precise_timers{};
+  IoContext::IoBudgets budgets;
+  // Incremented by every `run` call, send budgets are shared by all sends of the same iteration.
+  uint64_t iteration{};
+
+  std::optional<base::PreciseTime> idle_buffer_release_after;
+  base::PreciseTime next_idle_buffer_sweep{};
+
+  std::vector<TcpListenerImpl*> tcp_listener_poll_updates;
+  std::vector<TcpConnectionImpl*> tcp_connection_poll_updates;
+  std::vector<UdpSocketImpl*> udp_socket_poll_updates;
+
+  std::vector<std::shared_ptr<TcpConnectionImpl>> tcp_connection_flushes;
+  std::vector<std::shared_ptr<TcpConnectionImpl>> tcp_connection_flushes_read;
+  std::vector<std::shared_ptr<UdpSocketImpl>> udp_socket_flushes;
+  std::vector<std::shared_ptr<UdpSocketImpl>> udp_socket_flushes_read;
+
+  std::vector<std::shared_ptr<TcpListenerImpl>> signaled_tcp_listeners;
+  std::vector<std::shared_ptr<TcpConnectionImpl>> signaled_tcp_connections;
+  std::vector<std::shared_ptr<UdpSocketImpl>> signaled_udp_sockets;
 
   IpResolverImpl ip_resolver;
   TimerManagerImpl timer_manager;
 
-  std::vector<std::move_only_function<void()>> deferred_work_write;
-  std::vector<std::move_only_function<void()>> deferred_work_read;
+  std::vector<Task> deferred_work_write;
+  std::vector<Task> deferred_work_read;
 
-  std::mutex deferred_work_atomic_mutex;
-  std::vector<std::move_only_function<void()>> deferred_work_atomic_write;
-  std::vector<std::move_only_function<void()>> deferred_work_atomic_read;
+  struct StatCounters {
+    std::atomic_uint64_t iterations{};
+    std::atomic_uint64_t signaled_entries{};
+    std::atomic_uint64_t accepted_connections{};
+    std::atomic_uint64_t tcp_connections{};
+    std::atomic_uint64_t wakeups{};
+    std::atomic_uint64_t poll_wait_time_ns{};
+  };
+  StatCounters stat_counters;
+
+  // Work posted from other threads. Only the post that finds the queue empty wakes up the context,
+  // later ones are picked up by the same batch.
+  MpscQueue<Task> deferred_work_atomic;
+
+  // Set while the context is blocked (or about to block) in poll. Other threads only interrupt
+  // the poll when it is set, otherwise they leave `wakeup_pending` for the context to see before
+  // it blocks.
+  std::atomic_bool sleeping_in_poll{};
+  std::atomic_bool wakeup_pending{};
+
+  enum class PollEntryOwner : uint32_t {
+    TcpListener,
+    TcpConnection,
+    UdpSocket,
+  };
 
   enum class PendingConnectionStatus {
     StillWaiting,
@@ -46,7 +98,11 @@ class IoContextImpl {
     Failed,
   };
 
-  void register_poll_entries();
+  void update_tcp_listener_poll_entry(TcpListenerImpl& listener);
+  void update_tcp_connection_poll_entry(TcpConnectionImpl& connection);
+  void update_udp_socket_poll_entry(UdpSocketImpl& socket);
+
+  bool update_poll_entries();
 
   void handle_tcp_listener_events(const sock::Poller::PollEntry& entry,
                                   const std::shared_ptr<TcpListenerImpl>& listener);
@@ -58,9 +114,15 @@ class IoContextImpl {
 
   void handle_udp_socket_events(const sock::Poller::PollEntry& entry,
                                 const std::shared_ptr<UdpSocketImpl>& socket);
+  void send_udp_datagrams(const std::shared_ptr<UdpSocketImpl>& socket);
 
+  void collect_signaled_entries();
   void handle_poll_events();
 
+  void flush_tcp_connections();
+  void flush_udp_sockets();
+  void release_idle_buffers(base::PreciseTime now);
+
   void run_deferred_work();
   void run_deferred_work_atomic();
 
@@ -73,10 +135,19 @@ class IoContextImpl {
 
   bool has_any_non_atomic_work() const;
 
+  // Counters are only written by the thread running the context so they don't need atomic RMW.
+  static void add_to_stat_counter(std::atomic_uint64_t& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
  public:
   CLASS_NON_COPYABLE_NON_MOVABLE(IoContextImpl)
 
-  IoContextImpl();
+  explicit IoContextImpl(const IoContext::CreateParameters& parameters);
+
+  const IoContext::IoBudgets& io_budgets() const { return budgets; }
+  uint64_t current_iteration() const { return iteration; }
+  IoContext::Stats stats() const;
 
   void register_tcp_listener(std::shared_ptr<TcpListenerImpl> listener);
   void unregister_tcp_listener(TcpListenerImpl* listener);
@@ -87,19 +158,32 @@ class IoContextImpl {
   void register_udp_socket(std::shared_ptr<UdpSocketImpl> socket);
   void unregister_udp_socket(UdpSocketImpl* socket);
 
-  void queue_deferred_work(std::move_only_function<void()> callback);
-  void queue_deferred_work_atomic(std::move_only_function<void()> callback);
+  void queue_poll_update(TcpListenerImpl* listener);
+  void queue_poll_update(TcpConnectionImpl* connection);
+  void queue_poll_update(UdpSocketImpl* socket);
+
+  void remove_poll_entry(sock::Poller::PollEntry& entry);
+
+  void queue_data_sent_notification(TcpConnectionImpl* connection);
+  void queue_tcp_connection_flush(TcpConnectionImpl* connection);
+  void queue_udp_socket_flush(UdpSocketImpl* socket);
+
+  void queue_deferred_work(Task callback);
+  void queue_deferred_work_atomic(Task callback);
 
   void queue_ip_resolve(std::string hostname,
                         std::move_only_function<void(Status, std::vector<IpAddress>)> callback);
 
-  TimerManagerImpl::TimerKey register_timer(base::PreciseTime deadline,
-                                            std::move_only_function<void()> callback);
+  TimerManagerImpl::TimerKey register_timer(base::PreciseTime deadline, Task callback);
   void unregister_timer(const TimerManagerImpl::TimerKey& key);
 
   [[nodiscard]] IoContext::RunResult run(const IoContext::RunParameters& parameters);
   void notify();
 
+  // Called by other threads after publishing work for the context. Unlike `notify` it doesn't
+  // interrupt the poller when the context is awake and will pick up the work anyway.
+  void wake_up();
+
   void drain();
 };
 
@@ -19,7 +19,7 @@ void IpResolverImpl::worker_run() {
         .resolved_ips = std::move(ips),
         .callback = std::move(request.callback),
       });
-      io_context.notify();
+      io_context.wake_up();
     }
 
     requests.clear();
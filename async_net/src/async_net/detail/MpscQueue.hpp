@@ -0,0 +1,180 @@
+#pragma once
+#include <base/Panic.hpp>
+#include <base/macro/ClassTraits.hpp>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace async_net::detail {
+
+// Lock-free multi-producer single-consumer queue. Producers push nodes onto a linked stack and the
+// consumer takes the whole stack at once, so items are always consumed in batches. Nodes come from
+// a pool owned by the queue and go back to it once consumed, so pushing only allocates (under a
+// mutex) when the pool has to grow.
+template <typename T>
+class MpscQueue {
+  constexpr static uint32_t no_node = std::numeric_limits<uint32_t>::max();
+  // Pool blocks double in size, `max_pool_blocks` of them hold almost 2^32 nodes.
+  constexpr static uint32_t first_pool_block_size = 64;
+  constexpr static uint32_t max_pool_blocks = 26;
+
+  struct Node {
+    // Empty while the node is free.
+    std::optional<T> value;
+    Node* next{};
+
+    uint32_t index{};
+    std::atomic<uint32_t> next_free{no_node};
+  };
+
+  std::atomic<Node*> head{};
+
+  // Free nodes form a stack linked by indices. Its head holds the index of the first free node in
+  // the low 32 bits and a version incremented by every change in the high ones, so a producer
+  // popping a node which was meanwhile popped and pushed again fails instead of corrupting it.
+  std::atomic<uint64_t> free_head{no_node};
+  std::array<std::atomic<Node*>, max_pool_blocks> pool_blocks{};
+  uint32_t pool_block_count{};
+  std::mutex pool_mutex;
+
+  static uint32_t pool_block_start(uint32_t block) {
+    return first_pool_block_size * ((uint32_t(1) << block) - 1);
+  }
+
+  static uint64_t next_free_head(uint64_t free_head, uint32_t index) {
+    return ((free_head >> 32) + 1) << 32 | index;
+  }
+
+  Node& pool_node(uint32_t index) {
+    const auto block = uint32_t(std::bit_width(index / first_pool_block_size + 1) - 1);
+    return pool_blocks[block].load(std::memory_order_acquire)[index - pool_block_start(block)];
+  }
+
+  void release_nodes(Node& first, Node& last) {
+    auto previous_free = free_head.load(std::memory_order_relaxed);
+    do {
+      last.next_free.store(uint32_t(previous_free), std::memory_order_relaxed);
+    } while (!free_head.compare_exchange_weak(previous_free,
+                                              next_free_head(previous_free, first.index),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+  }
+
+  Node* try_acquire_node() {
+    auto free = free_head.load(std::memory_order_acquire);
+    while (uint32_t(free) != no_node) {
+      auto& node = pool_node(uint32_t(free));
+      // Stale if the node was taken meanwhile, but then the version makes the exchange fail.
+      const auto next_free = node.next_free.load(std::memory_order_relaxed);
+      if (free_head.compare_exchange_weak(free, next_free_head(free, next_free),
+                                          std::memory_order_acquire, std::memory_order_acquire)) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  Node* acquire_node() {
+    if (const auto node = try_acquire_node()) {
+      return node;
+    }
+
+    std::lock_guard lock(pool_mutex);
+
+    // Another producer might have grown the pool while we were waiting.
+    if (const auto node = try_acquire_node()) {
+      return node;
+    }
+
+    verify(pool_block_count < max_pool_blocks, "MPSC queue node pool is exhausted");
+
+    const auto block = pool_block_count++;
+    const auto block_size = first_pool_block_size << block;
+    const auto block_start = pool_block_start(block);
+
+    const auto nodes = new Node[block_size];
+    for (uint32_t i = 0; i < block_size; ++i) {
+      nodes[i].index = block_start + i;
+      if (i > 1) {
+        nodes[i - 1].next_free.store(block_start + i, std::memory_order_relaxed);
+      }
+    }
+    pool_blocks[block].store(nodes, std::memory_order_release);
+
+    // The first node is used right away, the rest becomes free.
+    release_nodes(nodes[1], nodes[block_size - 1]);
+    return &nodes[0];
+  }
+
+ public:
+  CLASS_NON_COPYABLE_NON_MOVABLE(MpscQueue)
+
+  MpscQueue() = default;
+  ~MpscQueue() {
+    consume_all([](T&&) {});
+
+    for (uint32_t block = 0; block < pool_block_count; ++block) {
+      delete[] pool_blocks[block].load(std::memory_order_relaxed);
+    }
+  }
+
+  // Returns true if the queue was empty (so the consumer might need to be woken up).
+  bool push(T value) {
+    const auto node = acquire_node();
+    node->value.emplace(std::move(value));
+
+    auto previous_head = head.load(std::memory_order_relaxed);
+    do {
+      node->next = previous_head;
+    } while (!head.compare_exchange_weak(previous_head, node, std::memory_order_release,
+                                         std::memory_order_relaxed));
+
+    return previous_head == nullptr;
+  }
+
+  bool empty() const { return head.load(std::memory_order_relaxed) == nullptr; }
+
+  // Must be called only by the consumer. Passes all queued items to `callback` in push order and
+  // returns their count.
+  template <typename Fn>
+  size_t consume_all(Fn&& callback) {
+    auto node = head.exchange(nullptr, std::memory_order_acquire);
+
+    Node* reversed = nullptr;
+    while (node) {
+      const auto next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+
+    // Consumed nodes are linked into a chain of free nodes and released at once.
+    size_t count = 0;
+    Node* last = nullptr;
+    for (auto current = reversed; current; current = current->next) {
+      callback(std::move(*current->value));
+      current->value.reset();
+
+      if (last) {
+        last->next_free.store(current->index, std::memory_order_relaxed);
+      }
+      last = current;
+      count++;
+    }
+
+    if (reversed) {
+      release_nodes(*reversed, *last);
+    }
+
+    return count;
+  }
+};
+
+}  // namespace async_net::detail
@@ -0,0 +1,77 @@
+#include "TcpConnectionHandoff.hpp"
+
+#include <async_net/IoContext.hpp>
+#include <async_net/IoContextPool.hpp>
+
+#include <base/Panic.hpp>
+
+#include <limits>
+
+namespace async_net::detail {
+
+TcpConnectionHandoff::Target& TcpConnectionHandoff::choose_target() {
+  size_t target_index = next_target;
+
+  if (policy == TcpListener::HandoffPolicy::LeastConnections) {
+    // Start from the round-robin position so that ties are spread between targets.
+    uint64_t min_load = std::numeric_limits<uint64_t>::max();
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+      const auto index = (next_target + i) % targets.size();
+      const auto& target = *targets[index];
+
+      const auto load = target.context.stats().tcp_connections +
+                        target.pending_count.load(std::memory_order_relaxed);
+      if (load < min_load) {
+        min_load = load;
+        target_index = index;
+      }
+    }
+  }
+
+  next_target = (target_index + 1) % targets.size();
+
+  return *targets[target_index];
+}
+
+void TcpConnectionHandoff::receive_connections(std::shared_ptr<TcpConnectionHandoff> self,
+                                               Target& target) {
+  const auto received_count = target.sockets.consume_all([&](sock::StreamSocket socket) {
+    TcpConnection connection{target.context, std::move(socket)};
+    on_accept(std::move(connection));
+  });
+
+  // Connections register themselves in deferred work queued above, keep them counted as pending
+  // until then.
+  target.context.post([self = std::move(self), &target, received_count] {
+    target.pending_count.fetch_sub(received_count, std::memory_order_relaxed);
+  });
+}
+
+TcpConnectionHandoff::TcpConnectionHandoff(
+  IoContextPool& pool,
+  TcpListener::HandoffPolicy policy,
+  std::move_only_function<void(TcpConnection) const> on_accept)
+    : policy(policy), on_accept(std::move(on_accept)) {
+  verify(pool.size() > 0, "cannot hand off connections to an empty pool");
+
+  targets.reserve(pool.size());
+  for (size_t i = 0; i < pool.size(); ++i) {
+    targets.push_back(std::make_unique<Target>(pool.context(i)));
+  }
+}
+
+void TcpConnectionHandoff::hand_off(std::shared_ptr<TcpConnectionHandoff> self,
+                                    sock::StreamSocket socket) {
+  auto& target = choose_target();
+
+  target.pending_count.fetch_add(1, std::memory_order_relaxed);
+
+  // Only the first connection of a batch wakes up the target context.
+  if (target.sockets.push(std::move(socket))) {
+    target.context.post_atomic(
+      [self = std::move(self), &target] { self->receive_connections(self, target); });
+  }
+}
+
+}  // namespace async_net::detail
@@ -0,0 +1,57 @@
+#pragma once
+#include "MpscQueue.hpp"
+
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <socklib/Socket.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace async_net {
+
+class IoContext;
+class IoContextPool;
+
+namespace detail {
+
+// Distributes sockets accepted by a listener between contexts of a pool. Sockets are pushed to a
+// lock-free queue of the target context, which is woken up once per batch and creates connections
+// on its own thread.
+class TcpConnectionHandoff {
+  struct Target {
+    IoContext& context;
+    MpscQueue<sock::StreamSocket> sockets;
+
+    // Handed off connections which aren't registered in the target context yet.
+    std::atomic_size_t pending_count{};
+
+    explicit Target(IoContext& context) : context(context) {}
+  };
+
+  std::vector<std::unique_ptr<Target>> targets;
+  TcpListener::HandoffPolicy policy;
+  size_t next_target{};
+
+  // Shared by all targets (the handoff itself is kept alive by their queued work), so it's called
+  // concurrently from their threads.
+  std::move_only_function<void(TcpConnection) const> on_accept;
+
+  Target& choose_target();
+  void receive_connections(std::shared_ptr<TcpConnectionHandoff> self, Target& target);
+
+ public:
+  TcpConnectionHandoff(IoContextPool& pool,
+                       TcpListener::HandoffPolicy policy,
+                       std::move_only_function<void(TcpConnection) const> on_accept);
+
+  // Must be called on the thread of the accepting context.
+  void hand_off(std::shared_ptr<TcpConnectionHandoff> self, sock::StreamSocket socket);
+};
+
+}  // namespace detail
+
+}  // namespace async_net
@@ -7,20 +7,53 @@
 #include <base/Log.hpp>
 #include <base/Panic.hpp>
 
+#include <array>
+#include <limits>
+
 namespace async_net::detail {
 
-base::BinaryBuffer& TcpConnectionImpl::acquire_send_buffer() {
-  if (send_buffer_offset > 0) {
-    send_buffer.trim_front(send_buffer_offset);
-    send_buffer_offset = 0;
+static void compact_consumed_data(base::BinaryBuffer& buffer, size_t& consumed_size) {
+  if (consumed_size == buffer.size()) {
+    buffer.clear();
+    consumed_size = 0;
+  } else if (consumed_size >= buffer.size() - consumed_size) {
+    // Moves at most as many bytes as were consumed since the last compaction.
+    buffer.trim_front(consumed_size);
+    consumed_size = 0;
   }
+}
+
+base::BinaryBuffer& TcpConnectionImpl::acquire_send_buffer() {
+  request_poll_update();
   return send_buffer;
 }
 
-size_t TcpConnectionImpl::send_buffer_size() const {
+void TcpConnectionImpl::release_send_buffer() {
+  if (!eager_send || send_blocked || !can_send_packets ||
+      state != TcpConnection::State::Connected || context_index == invalid_context_index) {
+    return;
+  }
+
+  if (cork_sends) {
+    context.impl_->queue_tcp_connection_flush(this);
+    return;
+  }
+
+  // Errors will be reported by the poller.
+  const auto [send_status, bytes_sent] = send_buffered_data();
+  if (bytes_sent > 0) {
+    context.impl_->queue_data_sent_notification(this);
+  }
+}
+
+size_t TcpConnectionImpl::copied_send_size() const {
   return send_buffer.size() - send_buffer_offset;
 }
 
+size_t TcpConnectionImpl::send_buffer_size() const {
+  return copied_send_size() + shared_send_size;
+}
+
 size_t TcpConnectionImpl::send_buffer_remaining_size() const {
   const auto used_size = send_buffer_size();
   const auto max_size = send_buffer_max_size;
@@ -31,6 +64,594 @@ size_t TcpConnectionImpl::send_buffer_remaining_size() const {
   }
 }
 
+size_t TcpConnectionImpl::remaining_send_budget() {
+  const auto iteration = context.impl_->current_iteration();
+  if (send_budget_iteration != iteration) {
+    send_budget_iteration = iteration;
+    iteration_bytes_sent = 0;
+  }
+
+  // The budget might have been lowered after sending in this iteration.
+  return iteration_bytes_sent < send_budget ? send_budget - iteration_bytes_sent : 0;
+}
+
+size_t TcpConnectionImpl::relay_input_size() const {
+  return relay_input ? relay_input->buffered_size : 0;
+}
+
+bool TcpConnectionImpl::has_pending_sends() const {
+  return send_buffer_size() > 0 || relay_input_size() > 0 || !zero_copy_sends.empty();
+}
+
+void TcpConnectionImpl::queue_shared_entry(SharedSendEntry entry) {
+  shared_send_size += entry.size();
+  entry.copied_data_position = copied_data_sent + copied_send_size();
+  shared_send_entries.push_back(std::move(entry));
+
+  request_poll_update();
+  release_send_buffer();
+}
+
+void TcpConnectionImpl::queue_shared_buffer(SharedBuffer buffer) {
+  if (!buffer.empty()) {
+    queue_shared_entry({
+      .buffer = std::move(buffer),
+    });
+  }
+}
+
+void TcpConnectionImpl::queue_file(int file_descriptor, uint64_t offset, size_t size) {
+  if (size > 0) {
+    queue_shared_entry({
+      .buffer = {},
+      .file_descriptor = file_descriptor,
+      .file_offset = offset,
+      .file_size = size,
+    });
+  }
+}
+
+TcpConnectionImpl::GatheredSendData TcpConnectionImpl::gather_send_data(
+  std::span<std::span<const uint8_t>> slices,
+  size_t max_size) const {
+  GatheredSendData gathered{};
+
+  const auto add_slice = [&](std::span<const uint8_t> slice) {
+    slice = slice.subspan(0, std::min(slice.size(), max_size - gathered.size));
+    if (!slice.empty()) {
+      slices[gathered.slice_count++] = slice;
+      gathered.size += slice.size();
+    }
+  };
+
+  auto copied_data = send_buffer.span().subspan(send_buffer_offset);
+  auto copied_data_position = copied_data_sent;
+
+  const auto zero_copy_min_size = zero_copy_enabled && zero_copy_threshold > 0
+                                    ? zero_copy_threshold
+                                    : std::numeric_limits<size_t>::max();
+
+  // Copied data up to the first shared buffer, the shared buffer, copied data up to the next one...
+  for (const auto& entry : shared_send_entries) {
+    if (gathered.slice_count + 2 > slices.size() || gathered.size == max_size) {
+      return gathered;
+    }
+
+    const auto copied_size = size_t(entry.copied_data_position - copied_data_position);
+    add_slice(copied_data.subspan(0, copied_size));
+    copied_data = copied_data.subspan(copied_size);
+    copied_data_position += copied_size;
+
+    if (entry.is_file()) {
+      // Files are sent with their own sendfile() call.
+      if (gathered.slice_count == 0) {
+        gathered.size = std::min(entry.file_size - entry.sent_size, max_size);
+        gathered.method = SendMethod::File;
+      }
+      return gathered;
+    }
+
+    const auto entry_data = entry.buffer.span().subspan(entry.sent_size);
+    if (entry_data.size() >= zero_copy_min_size) {
+      // Zero-copy sends contain only the shared buffer so they can be tracked until completion.
+      if (gathered.slice_count == 0) {
+        add_slice(entry_data);
+        gathered.method = SendMethod::ZeroCopy;
+      }
+      return gathered;
+    }
+
+    add_slice(entry_data);
+  }
+
+  if (gathered.slice_count < slices.size()) {
+    add_slice(copied_data);
+  }
+
+  return gathered;
+}
+
+void TcpConnectionImpl::consume_sent_data(size_t size) {
+  while (size > 0) {
+    if (!shared_send_entries.empty() &&
+        shared_send_entries.front().copied_data_position == copied_data_sent) {
+      auto& entry = shared_send_entries.front();
+
+      const auto consumed_size = std::min(size, entry.size() - entry.sent_size);
+      entry.sent_size += consumed_size;
+      shared_send_size -= consumed_size;
+      size -= consumed_size;
+
+      if (entry.sent_size == entry.size()) {
+        shared_send_entries.pop_front();
+      }
+    } else {
+      auto available_size = copied_send_size();
+      if (!shared_send_entries.empty()) {
+        const auto next_entry_position = shared_send_entries.front().copied_data_position;
+        available_size = std::min(available_size, size_t(next_entry_position - copied_data_sent));
+      }
+
+      const auto consumed_size = std::min(size, available_size);
+      verify(consumed_size > 0, "sent more data than was queued");
+
+      send_buffer_offset += consumed_size;
+      copied_data_sent += consumed_size;
+      size -= consumed_size;
+    }
+  }
+
+  compact_consumed_data(send_buffer, send_buffer_offset);
+}
+
+sock::Result<size_t> TcpConnectionImpl::send_zero_copy(std::span<const uint8_t> data) {
+  const auto result = socket.send_zero_copy(data);
+  if (result) {
+    // Zero-copy sends always start at the first shared buffer (see `gather_send_data`).
+    zero_copy_sends.push_back({
+      .index = zero_copy_send_count++,
+      .buffer = shared_send_entries.front().buffer,
+    });
+    return result;
+  }
+
+  if (result.status.would_block()) {
+    return result;
+  }
+
+  // Zero-copy sends fail with ENOBUFS when too many of them are waiting for completion. The
+  // regular send will report any actual connection error.
+  return socket.send(data);
+}
+
+size_t TcpConnectionImpl::process_zero_copy_completions() {
+  size_t completion_count = 0;
+
+  while (true) {
+    const auto [status, completion] = socket.receive_zero_copy_completion();
+    if (!status) {
+      break;
+    }
+
+    completion_count++;
+
+    // TCP completes sends in order so everything up to the last send in the range is done.
+    while (!zero_copy_sends.empty() &&
+           int32_t(zero_copy_sends.front().index - completion.last_send) <= 0) {
+      zero_copy_sends.pop_front();
+    }
+
+    // The kernel had to copy the data anyway (e.g. on loopback), so zero-copy sends only add the
+    // cost of tracking completions.
+    if (completion.copied) {
+      zero_copy_threshold = 0;
+    }
+  }
+
+  return completion_count;
+}
+
+sock::Result<size_t> TcpConnectionImpl::send_gathered_data(
+  const GatheredSendData& gathered,
+  std::span<const std::span<const uint8_t>> slices) {
+  if (gathered.method == SendMethod::ZeroCopy) {
+    return send_zero_copy(slices[0]);
+  }
+
+  if (gathered.method == SendMethod::File) {
+    // Files are always sent starting at the first entry (see `gather_send_data`).
+    const auto& entry = shared_send_entries.front();
+    return socket.send_file(entry.file_descriptor, entry.file_offset + entry.sent_size,
+                            gathered.size);
+  }
+
+  if (slices.size() == 1) {
+    return socket.send(slices[0]);
+  }
+  return socket.send_vectored(slices);
+}
+
+sock::Result<size_t> TcpConnectionImpl::send_buffered_data() {
+  constexpr static size_t max_send_fragment_size = 32 * 1024 * 1024;
+
+  std::array<std::span<const uint8_t>, sock::StreamSocket::max_vectored_buffers> slices;
+  sock::Status send_error{};
+  bool blocked = false;
+  size_t sent_size = 0;
+  const auto budget = remaining_send_budget();
+
+  // Data left after using up the budget keeps the socket in the poller's writable set, so it's sent
+  // in the next iteration.
+  while (sent_size < budget && (send_buffer_size() > 0 || relay_input_size() > 0)) {
+    const auto max_size = std::min(budget - sent_size, max_send_fragment_size);
+
+    size_t requested_size = 0;
+    sock::Result<size_t> send_result{};
+    if (send_buffer_size() > 0) {
+      const auto gathered = gather_send_data(slices, max_size);
+      const auto gathered_slices = std::span(slices).subspan(0, gathered.slice_count);
+      requested_size = gathered.size;
+      send_result = send_gathered_data(gathered, gathered_slices);
+      if (send_result) {
+        consume_sent_data(send_result.value);
+      }
+    } else {
+      // Relayed data is sent once everything queued on the connection itself has been sent.
+      requested_size = std::min(max_size, relay_input_size());
+      send_result = send_relayed_data(requested_size);
+    }
+
+    const auto [send_status, bytes_sent] = send_result;
+    if (!send_status) {
+      if (!send_status.would_block()) {
+        send_error = send_status;
+      }
+
+      blocked = true;
+      break;
+    }
+
+    sent_size += bytes_sent;
+
+    if (bytes_sent < requested_size) {
+      blocked = true;
+      break;
+    }
+  }
+
+  // Don't attempt eager sends until the poller reports that the socket is writable again.
+  send_blocked = blocked;
+
+  iteration_bytes_sent += sent_size;
+  total_bytes_sent += sent_size;
+
+  return {
+    .status = send_error,
+    .value = sent_size,
+  };
+}
+
+sock::Result<size_t> TcpConnectionImpl::send_relayed_data(size_t max_size) {
+  // Keep the relay alive, the connection stops referencing it once it's drained and the source
+  // has detached.
+  const auto relay = relay_input;
+
+  const auto result = socket.send_from_pipe(relay->pipe, std::min(max_size, relay->buffered_size));
+  if (result && result.value > 0) {
+    relay->buffered_size -= result.value;
+    relay->pipe_full = false;
+
+    if (relay->source) {
+      relay->source->request_poll_update();
+    }
+  }
+
+  if (relay->buffered_size == 0 && !relay->source) {
+    relay_input = nullptr;
+  }
+
+  return result;
+}
+
+std::span<const uint8_t> TcpConnectionImpl::pending_received_data() const {
+  return receive_buffer.span().subspan(receive_buffer_offset);
+}
+
+void TcpConnectionImpl::consume_received_data(size_t size) {
+  verify(size <= receive_buffer.size() - receive_buffer_offset,
+         "consumed more data than was received");
+
+  receive_buffer_offset += size;
+  compact_consumed_data(receive_buffer, receive_buffer_offset);
+}
+
+bool TcpConnectionImpl::relay_to(TcpConnectionImpl& destination) {
+  if (&destination == this || &destination.context != &context || relay_output ||
+      destination.relay_input || state != TcpConnection::State::Connected ||
+      destination.state != TcpConnection::State::Connected) {
+    return false;
+  }
+
+  auto [status, pipe] = sock::KernelPipe::create();
+  if (!status) {
+    log_error("failed to create TCP relay pipe: {}", status.stringify());
+    return false;
+  }
+
+  relay_output = std::make_shared<TcpRelay>(TcpRelay{
+    .pipe = std::move(pipe),
+    .source = this,
+    .destination = &destination,
+  });
+  destination.relay_input = relay_output;
+
+  if (!dispatching_received_data) {
+    relay_pending_received_data();
+  }
+
+  request_poll_update();
+  destination.request_poll_update();
+
+  return true;
+}
+
+void TcpConnectionImpl::relay_pending_received_data() {
+  // Data which was received before relaying started but wasn't consumed has to be sent before
+  // anything goes through the pipe.
+  if (const auto pending_data = pending_received_data(); !pending_data.empty()) {
+    auto& destination = *relay_output->destination;
+    destination.acquire_send_buffer().append(pending_data);
+    destination.release_send_buffer();
+
+    consume_received_data(pending_data.size());
+  }
+}
+
+sock::Status TcpConnectionImpl::receive_relayed_data() {
+  // Keep the relay alive, sending to the destination may detach it.
+  const auto relay = relay_output;
+
+  sock::Status receive_error{};
+  size_t total_bytes_received = 0;
+
+  // Data left after using up the budget keeps the socket readable so it's received in the next
+  // iteration.
+  while (total_bytes_received < receive_budget && !relay->pipe_full) {
+    const auto pipe_space = relay->pipe.capacity() - relay->buffered_size;
+    if (pipe_space == 0) {
+      relay->pipe_full = true;
+      break;
+    }
+
+    const auto max_receive_amount = std::min(receive_budget - total_bytes_received, pipe_space);
+    const auto [receive_status, bytes_received] =
+      socket.receive_to_pipe(relay->pipe, max_receive_amount);
+    if (!receive_status) {
+      if (!receive_status.would_block()) {
+        receive_error = receive_status;
+      } else if (relay->buffered_size > 0) {
+        // The socket may have run out of data or the pipe may have run out of slots. Stop
+        // receiving until the destination drains the pipe as only that can tell them apart.
+        relay->pipe_full = true;
+      }
+      break;
+    }
+
+    relay->buffered_size += bytes_received;
+    total_bytes_received += bytes_received;
+
+    if (bytes_received < max_receive_amount) {
+      break;
+    }
+  }
+
+  if (total_bytes_received > 0) {
+    this->total_bytes_received += total_bytes_received;
+
+    // The destination might have detached while receiving.
+    if (relay->source) {
+      relay->destination->request_poll_update();
+      relay->destination->release_send_buffer();
+    }
+  }
+
+  return receive_error;
+}
+
+void TcpConnectionImpl::detach_relay_destination() {
+  if (!relay_output) {
+    return;
+  }
+
+  const auto relay = std::move(relay_output);
+  relay->source = nullptr;
+
+  // Data left in the pipe is still sent by the destination.
+  const auto destination = relay->destination;
+  if (relay->buffered_size == 0) {
+    destination->relay_input = nullptr;
+  }
+  destination->request_poll_update();
+}
+
+void TcpConnectionImpl::detach_relay_source() {
+  if (!relay_input || !relay_input->source) {
+    return;
+  }
+
+  const auto source = relay_input->source;
+  source->relay_output = nullptr;
+  source->request_poll_update();
+
+  relay_input->source = nullptr;
+  if (relay_input->buffered_size == 0) {
+    relay_input = nullptr;
+  }
+}
+
+void TcpConnectionImpl::update_receive_fragment_size(size_t bytes_received) {
+  constexpr static uint32_t shrink_after_small_receives = 4;
+
+  received_since_idle_sweep = true;
+
+  if (bytes_received >= receive_fragment_size) {
+    receive_fragment_size = std::min(receive_fragment_size * 2, max_receive_fragment_size);
+    small_receive_streak = 0;
+  } else if (bytes_received <= receive_fragment_size / 4) {
+    if (++small_receive_streak >= shrink_after_small_receives) {
+      receive_fragment_size = std::max(receive_fragment_size / 2, min_receive_fragment_size);
+      small_receive_streak = 0;
+    }
+  } else {
+    small_receive_streak = 0;
+  }
+}
+
+void TcpConnectionImpl::shrink_receive_buffer() {
+  // Free memory left over from a burst once everything was consumed. The next receive will
+  // allocate a buffer matching the current fragment size.
+  if (receive_buffer.empty() && receive_buffer.capacity() > receive_fragment_size * 2) {
+    receive_buffer.clear_and_deallocate();
+  }
+}
+
+void TcpConnectionImpl::release_idle_buffers() {
+  if (!received_since_idle_sweep && receive_buffer.empty()) {
+    receive_buffer.clear_and_deallocate();
+  }
+  received_since_idle_sweep = false;
+
+  if (copied_send_size() == 0 && send_buffer.capacity() > 0) {
+    send_buffer.clear_and_deallocate();
+    send_buffer_offset = 0;
+  }
+}
+
+void TcpConnectionImpl::send_data_vectored(std::span<const std::span<const uint8_t>> slices) {
+  size_t sent_size = 0;
+
+  // Slices can only skip the send buffer if nothing queued earlier has to be sent before them.
+  if (eager_send && !cork_sends && !send_blocked && can_send_packets &&
+      state == TcpConnection::State::Connected && context_index != invalid_context_index &&
+      send_buffer_size() == 0 && relay_input_size() == 0) {
+    // The socket sends at most `max_vectored_buffers` non-empty slices at once, so longer lists are
+    // sent in chunks, as long as the send budget of this iteration allows. Errors will be reported
+    // by the poller.
+    const auto budget = remaining_send_budget();
+    std::array<std::span<const uint8_t>, sock::StreamSocket::max_vectored_buffers> chunk;
+    size_t slice_index = 0;
+    size_t slice_offset = 0;
+    bool blocked = false;
+
+    while (sent_size < budget && slice_index < slices.size()) {
+      size_t chunk_slice_count = 0;
+      size_t chunk_size = 0;
+      size_t chunk_end_index = slice_index;
+      size_t chunk_end_offset = slice_offset;
+
+      while (chunk_end_index < slices.size() && chunk_slice_count < chunk.size() &&
+             chunk_size < budget - sent_size) {
+        const auto slice = slices[chunk_end_index].subspan(chunk_end_offset);
+        const auto chunk_slice =
+          slice.first(std::min(slice.size(), budget - sent_size - chunk_size));
+        if (!chunk_slice.empty()) {
+          chunk[chunk_slice_count++] = chunk_slice;
+          chunk_size += chunk_slice.size();
+        }
+
+        if (chunk_slice.size() < slice.size()) {
+          chunk_end_offset += chunk_slice.size();
+        } else {
+          chunk_end_index++;
+          chunk_end_offset = 0;
+        }
+      }
+
+      if (chunk_size == 0) {
+        break;
+      }
+
+      const auto [send_status, bytes_sent] =
+        socket.send_vectored(std::span(chunk).first(chunk_slice_count));
+      if (!send_status) {
+        blocked = true;
+        break;
+      }
+
+      sent_size += bytes_sent;
+
+      if (bytes_sent < chunk_size) {
+        blocked = true;
+        break;
+      }
+
+      slice_index = chunk_end_index;
+      slice_offset = chunk_end_offset;
+    }
+
+    send_blocked = blocked;
+
+    if (sent_size > 0) {
+      iteration_bytes_sent += sent_size;
+      total_bytes_sent += sent_size;
+      context.impl_->queue_data_sent_notification(this);
+    }
+  }
+
+  // Data which wasn't sent directly is owned by the caller so it has to be copied. It's then sent
+  // like data from `send_data` (eagerly or by the flush of corked sends).
+  auto& buffer = acquire_send_buffer();
+  for (auto slice : slices) {
+    const auto skipped_size = std::min(sent_size, slice.size());
+    sent_size -= skipped_size;
+    buffer.append(slice.subspan(skipped_size));
+  }
+
+  release_send_buffer();
+}
+
+void TcpConnectionImpl::set_no_delay(bool enabled) {
+  no_delay = enabled;
+  if (state == TcpConnection::State::Connected) {
+    apply_no_delay();
+  }
+}
+
+void TcpConnectionImpl::apply_no_delay() {
+  if (const auto status = socket.set_no_delay(no_delay); !status) {
+    log_error("failed to update TCP no delay option: {}", status.stringify());
+  }
+}
+
+void TcpConnectionImpl::set_zero_copy_threshold(size_t threshold) {
+  zero_copy_threshold = threshold;
+  if (state == TcpConnection::State::Connected) {
+    apply_zero_copy();
+  }
+}
+
+void TcpConnectionImpl::apply_zero_copy() {
+  if (zero_copy_enabled || zero_copy_threshold == 0) {
+    return;
+  }
+
+  if (const auto status = socket.set_zero_copy(true); !status) {
+    log_error("failed to enable TCP zero-copy sends: {}", status.stringify());
+    zero_copy_threshold = 0;
+    return;
+  }
+
+  zero_copy_enabled = true;
+}
+
+void TcpConnectionImpl::request_poll_update() {
+  context.impl_->queue_poll_update(this);
+}
+
+void TcpConnectionImpl::remove_poll_entry() {
+  context.impl_->remove_poll_entry(poll_entry);
+}
+
 void TcpConnectionImpl::cleanup() {
   on_connected = nullptr;
   on_closed = nullptr;
@@ -52,6 +673,12 @@ bool TcpConnectionImpl::prepare_unregister() {
   }
   unregister_pending = true;
 
+  remove_poll_entry();
+
+  detach_relay_source();
+  relay_input = nullptr;
+  detach_relay_destination();
+
   socket = {};
   connecting_state = {};
   can_send_packets = false;
@@ -74,6 +701,13 @@ void TcpConnectionImpl::enter_connected_state(bool invoke_callbacks) {
   state = TcpConnection::State::Connected;
   can_send_packets = true;
 
+  if (no_delay) {
+    apply_no_delay();
+  }
+  apply_zero_copy();
+
+  request_poll_update();
+
   if (invoke_callbacks && on_connected) {
     on_connected({});
   }
@@ -102,6 +736,9 @@ void TcpConnectionImpl::setup_connecting_timeout(const std::shared_ptr<TcpConnec
 
 bool TcpConnectionImpl::attempt_next_address(const std::shared_ptr<TcpConnectionImpl>& self,
                                              Status previous_connection_status) {
+  // Current connecting socket is going to be closed.
+  remove_poll_entry();
+
   if (connecting_state->error_status) {
     connecting_state->error_status = previous_connection_status;
   }
@@ -127,6 +764,7 @@ bool TcpConnectionImpl::attempt_next_address(const std::shared_ptr<TcpConnection
       connecting_state->next_address_index = i + 1;
 
       setup_connecting_timeout(self);
+      request_poll_update();
     }
 
     return true;
@@ -201,7 +839,11 @@ void TcpConnectionImpl::connect_immediate(std::shared_ptr<TcpConnectionImpl> sel
   cleanup_before_register();
 }
 
-TcpConnectionImpl::TcpConnectionImpl(IoContext& context) : context(context) {}
+TcpConnectionImpl::TcpConnectionImpl(IoContext& context) : context(context) {
+  const auto& budgets = context.impl_->io_budgets();
+  receive_budget = budgets.tcp_receive_bytes;
+  send_budget = budgets.tcp_send_bytes;
+}
 
 void TcpConnectionImpl::startup(std::shared_ptr<TcpConnectionImpl> self,
                                 sock::StreamSocket connection) {
@@ -272,11 +914,16 @@ void TcpConnectionImpl::shutdown(std::shared_ptr<TcpConnectionImpl> self) {
 
     state = TcpConnection::State::Shutdown;
 
+    // Data already in the relay pipe is still sent before closing.
+    detach_relay_source();
+
+    request_poll_update();
+
     if (should_unregister) {
       context.post([self = std::move(self)] {
         self->cleanup();
 
-        if (self->send_buffer_size() == 0) {
+        if (!self->has_pending_sends()) {
           if (self->prepare_unregister()) {
             self->context.impl_->unregister_tcp_connection(self.get());
           }
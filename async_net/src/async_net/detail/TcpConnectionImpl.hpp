@@ -2,6 +2,7 @@
 #include "Common.hpp"
 
 #include <async_net/IpAddress.hpp>
+#include <async_net/SharedBuffer.hpp>
 #include <async_net/Status.hpp>
 #include <async_net/TcpConnection.hpp>
 #include <async_net/Timer.hpp>
@@ -10,6 +11,7 @@
 
 #include <base/containers/BinaryBuffer.hpp>
 
+#include <deque>
 #include <functional>
 #include <memory>
 
@@ -22,6 +24,20 @@ namespace detail {
 
 class IoContextImpl;
 class ContextEntryRegistration;
+class TcpConnectionImpl;
+
+// Kernel pipe through which one connection's received data is spliced into another one (see
+// `TcpConnection::relay_to`). Both connections reference it, so the data left in the pipe can
+// still be sent after the source has closed.
+struct TcpRelay {
+  sock::KernelPipe pipe;
+  size_t buffered_size{};
+  // The pipe didn't accept more data. Cleared once the destination drains some of it.
+  bool pipe_full{};
+  // Cleared when the connection stops taking part in the relay.
+  TcpConnectionImpl* source{};
+  TcpConnectionImpl* destination{};
+};
 
 class TcpConnectionImpl {
   friend TcpConnection;
@@ -48,6 +64,9 @@ class TcpConnectionImpl {
   IoContext& context;
   size_t context_index{invalid_context_index};
 
+  sock::Poller::PollEntry poll_entry{};
+  bool poll_update_pending{};
+
   TcpConnection::State state{TcpConnection::State::Connecting};
   bool unregister_pending{};
   bool can_send_packets{};
@@ -56,12 +75,74 @@ class TcpConnectionImpl {
   std::unique_ptr<ConnectingState> connecting_state;
 
   bool receive_packets{true};
+  // Set while `on_data_received` runs. The handler hasn't consumed the data it was given yet, so a
+  // relay started by it forwards the pending data only after it returns.
+  bool dispatching_received_data{};
 
+  // Consumed data at the front of the buffers is skipped using offsets and only compacted once it
+  // isn't smaller than the data left, which keeps consuming data O(1) amortized.
   base::BinaryBuffer receive_buffer;
+  size_t receive_buffer_offset{};
+  // Amount of data requested from the socket by a single receive. Grows when receives fill it up
+  // and shrinks after a few iterations that received much less.
+  size_t receive_fragment_size{initial_receive_fragment_size};
+  uint32_t small_receive_streak{};
+  // Cleared by the idle receive buffer sweep, set whenever data is received.
+  bool received_since_idle_sweep{};
   base::BinaryBuffer send_buffer;
   size_t send_buffer_offset{};
+
+  // Shared buffers and files are sent without copying them to `send_buffer`. Each one is sent once
+  // all data copied to `send_buffer` before it was queued has been sent (positions count all data
+  // ever copied to `send_buffer`).
+  struct SharedSendEntry {
+    SharedBuffer buffer;
+    // Files are streamed with sendfile() and have no buffer.
+    int file_descriptor{-1};
+    uint64_t file_offset{};
+    size_t file_size{};
+    size_t sent_size{};
+    uint64_t copied_data_position{};
+
+    bool is_file() const { return file_descriptor >= 0; }
+    size_t size() const { return is_file() ? file_size : buffer.size(); }
+  };
+  std::deque<SharedSendEntry> shared_send_entries;
+  size_t shared_send_size{};
+  uint64_t copied_data_sent{};
+
+  // Shared buffers which are large enough are sent with MSG_ZEROCOPY (see
+  // `TcpConnection::set_zero_copy_threshold`). The kernel keeps referencing their memory after the
+  // send so they stay here until it reports the send (identified by its index) as completed.
+  struct ZeroCopySend {
+    uint32_t index{};
+    SharedBuffer buffer;
+  };
+  std::deque<ZeroCopySend> zero_copy_sends;
+  uint32_t zero_copy_send_count{};
+  size_t zero_copy_threshold{};
+  // SO_ZEROCOPY stays set once enabled as completions for earlier sends can still arrive.
+  bool zero_copy_enabled{};
+
+  // Relay which this connection receives into and the one it sends from.
+  std::shared_ptr<TcpRelay> relay_output;
+  std::shared_ptr<TcpRelay> relay_input;
+
   size_t send_buffer_max_size{default_send_buffer_max_size};
   bool block_on_send_buffer_full{true};
+  bool eager_send{true};
+  bool cork_sends{};
+  bool send_blocked{};
+  bool flush_pending{};
+  bool data_sent_notification_pending{};
+  bool no_delay{};
+
+  // Per-iteration limits (see `IoContext::IoBudgets`). Eager sends, flushes and writability events
+  // of the same iteration (`send_budget_iteration`) share the send budget.
+  size_t receive_budget{};
+  size_t send_budget{};
+  uint64_t send_budget_iteration{};
+  size_t iteration_bytes_sent{};
 
   SocketAddress local_address{};
   SocketAddress peer_addreess{};
@@ -73,9 +154,63 @@ class TcpConnectionImpl {
   std::move_only_function<size_t(std::span<const uint8_t>)> on_data_received;
   std::move_only_function<void()> on_data_sent;
 
+  enum class SendMethod {
+    Regular,
+    ZeroCopy,
+    File,
+  };
+
+  struct GatheredSendData {
+    size_t slice_count{};
+    size_t size{};
+    SendMethod method{SendMethod::Regular};
+  };
+
   base::BinaryBuffer& acquire_send_buffer();
+  void release_send_buffer();
+  size_t copied_send_size() const;
   size_t send_buffer_size() const;
   size_t send_buffer_remaining_size() const;
+  size_t remaining_send_budget();
+  size_t relay_input_size() const;
+  bool has_pending_sends() const;
+
+  void queue_shared_entry(SharedSendEntry entry);
+  void queue_shared_buffer(SharedBuffer buffer);
+  void queue_file(int file_descriptor, uint64_t offset, size_t size);
+
+  GatheredSendData gather_send_data(std::span<std::span<const uint8_t>> slices,
+                                    size_t max_size) const;
+  void consume_sent_data(size_t size);
+  sock::Result<size_t> send_zero_copy(std::span<const uint8_t> data);
+  size_t process_zero_copy_completions();
+  sock::Result<size_t> send_gathered_data(const GatheredSendData& gathered,
+                                          std::span<const std::span<const uint8_t>> slices);
+  sock::Result<size_t> send_buffered_data();
+  sock::Result<size_t> send_relayed_data(size_t max_size);
+  void send_data_vectored(std::span<const std::span<const uint8_t>> slices);
+
+  std::span<const uint8_t> pending_received_data() const;
+  void consume_received_data(size_t size);
+
+  bool relay_to(TcpConnectionImpl& destination);
+  void relay_pending_received_data();
+  sock::Status receive_relayed_data();
+  void detach_relay_destination();
+  void detach_relay_source();
+
+  void update_receive_fragment_size(size_t bytes_received);
+  void shrink_receive_buffer();
+  void release_idle_buffers();
+
+  void set_no_delay(bool enabled);
+  void apply_no_delay();
+
+  void set_zero_copy_threshold(size_t threshold);
+  void apply_zero_copy();
+
+  void request_poll_update();
+  void remove_poll_entry();
 
   void cleanup();
   void cleanup_before_register();
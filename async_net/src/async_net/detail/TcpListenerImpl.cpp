@@ -1,5 +1,6 @@
 #include "TcpListenerImpl.hpp"
 #include "IoContextImpl.hpp"
+#include "TcpConnectionHandoff.hpp"
 
 #include <async_net/IoContext.hpp>
 #include <async_net/IpResolver.hpp>
@@ -9,10 +10,19 @@
 
 namespace async_net::detail {
 
+void TcpListenerImpl::request_poll_update() {
+  context.impl_->queue_poll_update(this);
+}
+
+void TcpListenerImpl::remove_poll_entry() {
+  context.impl_->remove_poll_entry(poll_entry);
+}
+
 void TcpListenerImpl::cleanup() {
   on_listening = nullptr;
   on_error = nullptr;
   on_accept = nullptr;
+  handoff = nullptr;
 }
 
 void TcpListenerImpl::cleanup_before_register() {
@@ -28,6 +38,8 @@ bool TcpListenerImpl::prepare_unregister() {
   }
   unregister_pending = true;
 
+  remove_poll_entry();
+
   socket = {};
 
   if (state != TcpListener::State::Error) {
@@ -38,7 +50,8 @@ bool TcpListenerImpl::prepare_unregister() {
 }
 
 void TcpListenerImpl::listen_immediate(std::shared_ptr<TcpListenerImpl> self,
-                                       std::span<const SocketAddress> addresses) {
+                                       std::span<const SocketAddress> addresses,
+                                       TcpListener::BindParameters parameters) {
   verify(!addresses.empty(), "address list is empty");
 
   if (state == TcpListener::State::Shutdown) {
@@ -48,10 +61,13 @@ void TcpListenerImpl::listen_immediate(std::shared_ptr<TcpListenerImpl> self,
   Status error_status{};
 
   for (const auto& address : addresses) {
-    auto [status, listener] = sock::Listener::bind(address, {
-                                                              .non_blocking = true,
-                                                              .reuse_address = true,
-                                                            });
+    auto [status, listener] =
+      sock::Listener::bind(address, {
+                                      .non_blocking = true,
+                                      .reuse_address = true,
+                                      .reuse_port = parameters.reuse_port,
+                                      .max_pending_connections = parameters.max_pending_connections,
+                                    });
 
     if (status) {
       state = TcpListener::State::Listening;
@@ -92,10 +108,12 @@ TcpListenerImpl::TcpListenerImpl(IoContext& context) : context(context) {}
 
 void TcpListenerImpl::startup(std::shared_ptr<TcpListenerImpl> self,
                               std::string hostname,
-                              uint16_t port) {
+                              uint16_t port,
+                              TcpListener::BindParameters parameters) {
   IpResolver::resolve(
     context, std::move(hostname),
-    [self = std::move(self), port](sock::Status status, std::vector<IpAddress> resolved_ips) {
+    [self = std::move(self), port, parameters](sock::Status status,
+                                               std::vector<IpAddress> resolved_ips) {
       if (self->state == TcpListener::State::Shutdown) {
         return self->cleanup_before_register();
       }
@@ -108,7 +126,7 @@ void TcpListenerImpl::startup(std::shared_ptr<TcpListenerImpl> self,
           socket_addresses.emplace_back(ip, port);
         }
 
-        self->listen_immediate(self, socket_addresses);
+        self->listen_immediate(self, socket_addresses, parameters);
       } else {
         self->state = TcpListener::State::Error;
 
@@ -124,16 +142,19 @@ void TcpListenerImpl::startup(std::shared_ptr<TcpListenerImpl> self,
 }
 
 void TcpListenerImpl::startup(std::shared_ptr<TcpListenerImpl> self,
-                              std::vector<SocketAddress> addresses) {
-  context.post([self = std::move(self), addresses = std::move(addresses)] {
-    self->listen_immediate(self, addresses);
+                              std::vector<SocketAddress> addresses,
+                              TcpListener::BindParameters parameters) {
+  context.post([self = std::move(self), addresses = std::move(addresses), parameters] {
+    self->listen_immediate(self, addresses, parameters);
   });
 }
 
-void TcpListenerImpl::startup(std::shared_ptr<TcpListenerImpl> self, SocketAddress address) {
-  context.post([self = std::move(self), address] {
+void TcpListenerImpl::startup(std::shared_ptr<TcpListenerImpl> self,
+                              SocketAddress address,
+                              TcpListener::BindParameters parameters) {
+  context.post([self = std::move(self), address, parameters] {
     const SocketAddress socket_addresses[]{address};
-    self->listen_immediate(self, socket_addresses);
+    self->listen_immediate(self, socket_addresses, parameters);
   });
 }
 
@@ -143,6 +164,8 @@ void TcpListenerImpl::shutdown(std::shared_ptr<TcpListenerImpl> self) {
 
     state = TcpListener::State::Shutdown;
 
+    request_poll_update();
+
     if (should_unregister) {
       context.post([self = std::move(self)] {
         if (self->prepare_unregister()) {
@@ -20,6 +20,7 @@ namespace detail {
 
 class IoContextImpl;
 class ContextEntryRegistration;
+class TcpConnectionHandoff;
 
 class TcpListenerImpl {
   friend TcpListener;
@@ -29,6 +30,9 @@ class TcpListenerImpl {
   IoContext& context;
   size_t context_index{invalid_context_index};
 
+  sock::Poller::PollEntry poll_entry{};
+  bool poll_update_pending{};
+
   TcpListener::State state{TcpListener::State::Waiting};
   bool unregister_pending{};
 
@@ -39,22 +43,35 @@ class TcpListenerImpl {
   std::move_only_function<void()> on_listening;
   std::move_only_function<void(Status)> on_error;
   std::move_only_function<void(Status, TcpConnection)> on_accept;
+  std::shared_ptr<TcpConnectionHandoff> handoff;
+
+  void request_poll_update();
+  void remove_poll_entry();
 
   void cleanup();
   void cleanup_before_register();
   bool prepare_unregister();
 
   void listen_immediate(std::shared_ptr<TcpListenerImpl> self,
-                        std::span<const SocketAddress> addresses);
+                        std::span<const SocketAddress> addresses,
+                        TcpListener::BindParameters parameters);
 
  public:
   explicit TcpListenerImpl(IoContext& context);
 
   bool is_listening() const { return state == TcpListener::State::Listening; }
-
-  void startup(std::shared_ptr<TcpListenerImpl> self, std::string hostname, uint16_t port);
-  void startup(std::shared_ptr<TcpListenerImpl> self, std::vector<SocketAddress> addresses);
-  void startup(std::shared_ptr<TcpListenerImpl> self, SocketAddress address);
+  bool has_accept_handler() const { return on_accept || handoff; }
+
+  void startup(std::shared_ptr<TcpListenerImpl> self,
+               std::string hostname,
+               uint16_t port,
+               TcpListener::BindParameters parameters);
+  void startup(std::shared_ptr<TcpListenerImpl> self,
+               std::vector<SocketAddress> addresses,
+               TcpListener::BindParameters parameters);
+  void startup(std::shared_ptr<TcpListenerImpl> self,
+               SocketAddress address,
+               TcpListener::BindParameters parameters);
   void shutdown(std::shared_ptr<TcpListenerImpl> self);
 
   void unregister_during_runloop(std::shared_ptr<TcpListenerImpl> self);
@@ -2,51 +2,217 @@
 
 #include <base/Panic.hpp>
 
+#include <algorithm>
+#include <bit>
+
 namespace async_net::detail {
 
-TimerManagerImpl::TimerKey TimerManagerImpl::register_timer(
-  base::PreciseTime deadline,
-  std::move_only_function<void()> callback) {
-  const auto id = next_timer_id++;
+void TimerManagerImpl::link_node(uint32_t node_index, uint32_t slot) {
+  auto& node = nodes[node_index];
+  auto& slot_nodes = slots[slot];
+
+  node.slot = slot;
+  node.position = uint32_t(slot_nodes.size());
+  slot_nodes.push_back(node_index);
+
+  if (slot != due_slot) {
+    occupied_slots[slot / slot_count] |= uint64_t(1) << (slot % slot_count);
+  }
+}
+
+void TimerManagerImpl::unlink_node(uint32_t node_index) {
+  const auto& node = nodes[node_index];
+  auto& slot_nodes = slots[node.slot];
+
+  const auto last_index = slot_nodes.back();
+  slot_nodes[node.position] = last_index;
+  nodes[last_index].position = node.position;
+  slot_nodes.pop_back();
+
+  if (node.slot != due_slot && slot_nodes.empty()) {
+    occupied_slots[node.slot / slot_count] &= ~(uint64_t(1) << (node.slot % slot_count));
+  }
+}
+
+void TimerManagerImpl::place_node(uint32_t node_index) {
+  const auto tick = deadline_to_tick(nodes[node_index].deadline);
+  if (tick <= current_tick) {
+    return link_node(node_index, due_slot);
+  }
+
+  const auto delta = tick - current_tick;
+
+  uint32_t level = 0;
+  while (level + 1 < level_count && delta >= (uint64_t(1) << (slot_bits * (level + 1)))) {
+    level++;
+  }
+
+  // Timers that are too far in the future are placed in the furthest slot and get placed again
+  // when that slot is cascaded.
+  constexpr uint64_t max_delta = (uint64_t(1) << (slot_bits * level_count)) - 1;
+  const auto slot_tick = delta > max_delta ? current_tick + max_delta : tick;
+
+  const auto slot = uint32_t((slot_tick >> (slot_bits * level)) & (slot_count - 1));
+  link_node(node_index, level * slot_count + slot);
+}
+
+uint32_t TimerManagerImpl::allocate_node() {
+  if (!free_nodes.empty()) {
+    const auto node_index = free_nodes.back();
+    free_nodes.pop_back();
+    return node_index;
+  }
+
+  verify(nodes.size() < std::numeric_limits<uint32_t>::max(), "too many timers");
+
+  nodes.emplace_back();
+  callbacks.emplace_back();
+  return uint32_t(nodes.size() - 1);
+}
+
+void TimerManagerImpl::free_node(uint32_t node_index) {
+  auto& node = nodes[node_index];
+
+  node.slot = invalid_slot;
+  node.generation++;
+
+  free_nodes.push_back(node_index);
+  active_timers--;
+}
+
+void TimerManagerImpl::cascade_slot(uint32_t level, uint32_t slot) {
+  // Swap the slot out first as timers can be placed into the same slot again.
+  cascaded_nodes.swap(slots[level * slot_count + slot]);
+  occupied_slots[level] &= ~(uint64_t(1) << slot);
+
+  for (const auto node_index : cascaded_nodes) {
+    place_node(node_index);
+  }
+  cascaded_nodes.clear();
+}
+
+void TimerManagerImpl::advance_to_tick(uint64_t tick) {
+  while (current_tick < tick) {
+    const auto next_tick = next_wheel_tick();
+    if (!next_tick || *next_tick > tick) {
+      current_tick = tick;
+      break;
+    }
+
+    current_tick = *next_tick;
+
+    // Cascade from the highest level so that timers moved down can be cascaded again.
+    for (uint32_t level = level_count - 1; level > 0; --level) {
+      const auto shift = slot_bits * level;
+      if ((current_tick & ((uint64_t(1) << shift) - 1)) == 0) {
+        cascade_slot(level, uint32_t((current_tick >> shift) & (slot_count - 1)));
+      }
+    }
+
+    cascade_slot(0, uint32_t(current_tick & (slot_count - 1)));
+  }
+}
+
+std::optional<uint64_t> TimerManagerImpl::next_wheel_tick() const {
+  std::optional<uint64_t> next_tick;
+
+  for (uint32_t level = 0; level < level_count; ++level) {
+    const auto occupied = occupied_slots[level];
+    if (occupied == 0) {
+      continue;
+    }
+
+    // Slots are processed in order starting right after the current one.
+    const auto shift = slot_bits * level;
+    const auto current_slot = (current_tick >> shift) & (slot_count - 1);
+    const auto rotated = std::rotr(occupied, int((current_slot + 1) & (slot_count - 1)));
+    const auto distance = uint64_t(std::countr_zero(rotated)) + 1;
+
+    const auto tick = ((current_tick >> shift) + distance) << shift;
+    if (!next_tick || tick < *next_tick) {
+      next_tick = tick;
+    }
+  }
 
-  TimerEntry entry{
-    .id = id,
-    .deadline = deadline,
-    .callback = std::move(callback),
-  };
+  return next_tick;
+}
+
+TimerManagerImpl::TimerManagerImpl() {
+  current_tick = deadline_to_tick(base::PreciseTime::now());
+}
 
-  verify(timers.insert(std::move(entry)).second, "failed to register timer");
+TimerManagerImpl::TimerKey TimerManagerImpl::register_timer(base::PreciseTime deadline,
+                                                           Task callback) {
+  const auto node_index = allocate_node();
 
-  return {id, deadline};
+  auto& node = nodes[node_index];
+  node.deadline = deadline;
+  node.sequence = next_sequence++;
+  callbacks[node_index] = std::move(callback);
+
+  active_timers++;
+
+  place_node(node_index);
+
+  return {make_timer_id(node_index, node.generation), deadline};
 }
 
-std::move_only_function<void()> TimerManagerImpl::unregister_timer(const TimerKey& key) {
-  TimerEntry entry{
-    .id = key.id,
-    .deadline = key.deadline,
-  };
+Task TimerManagerImpl::unregister_timer(const TimerKey& key) {
+  const auto node_index = uint32_t(key.id);
+  const auto generation = uint32_t(key.id >> 32);
 
-  std::move_only_function<void()> callback;
+  Task callback;
 
-  if (auto it = timers.find(entry); it != timers.end()) {
-    callback = std::move(it->callback);
-    timers.erase(it);
+  if (node_index < nodes.size()) {
+    auto& node = nodes[node_index];
+    if (node.slot != invalid_slot && node.generation == generation) {
+      callback = std::move(callbacks[node_index]);
+      unlink_node(node_index);
+      free_node(node_index);
+    }
   }
 
   return callback;
 }
 
 void TimerManagerImpl::poll(base::PreciseTime now) {
-  auto it = timers.begin();
+  advance_to_tick(deadline_to_tick(now));
 
-  while (it != timers.end()) {
-    if (it->deadline > now) {
-      break;
+  // Remove expired timers from the due slot while keeping the order of remaining ones.
+  auto& due_nodes = slots[due_slot];
+  size_t remaining_count = 0;
+
+  for (const auto node_index : due_nodes) {
+    auto& node = nodes[node_index];
+    if (node.deadline <= now) {
+      fired_timers.push_back(FiredTimer{
+        .deadline = node.deadline,
+        .sequence = node.sequence,
+        .node = node_index,
+      });
+      free_node(node_index);
+    } else {
+      node.position = uint32_t(remaining_count);
+      due_nodes[remaining_count++] = node_index;
     }
-    pending_callbacks.emplace_back(std::move(it->callback));
-    it = timers.erase(it);
   }
 
+  due_nodes.resize(remaining_count);
+
+  std::sort(fired_timers.begin(), fired_timers.end(), [](const auto& a, const auto& b) {
+    if (a.deadline == b.deadline) {
+      return a.sequence < b.sequence;
+    } else {
+      return a.deadline < b.deadline;
+    }
+  });
+
+  // Freed nodes cannot be reused before their callbacks are moved out as no user code runs here.
+  for (const auto& timer : fired_timers) {
+    pending_callbacks.emplace_back(std::move(callbacks[timer.node]));
+  }
+  fired_timers.clear();
+
   for (auto& callback : pending_callbacks) {
     callback();
   }
@@ -54,28 +220,53 @@ void TimerManagerImpl::poll(base::PreciseTime now) {
 }
 
 void TimerManagerImpl::drain() {
-  for (auto& timer : timers) {
-    pending_callbacks.emplace_back(std::move(timer.callback));
+  for (uint32_t node_index = 0; node_index < nodes.size(); ++node_index) {
+    if (nodes[node_index].slot != invalid_slot) {
+      pending_callbacks.emplace_back(std::move(callbacks[node_index]));
+      free_node(node_index);
+    }
+  }
+
+  for (auto& slot_nodes : slots) {
+    slot_nodes.clear();
   }
+  occupied_slots.fill(0);
 
-  timers.clear();
   pending_callbacks.clear();
 }
 
 std::optional<base::PreciseTime> TimerManagerImpl::earliest_deadline() const {
-  if (timers.empty()) {
-    return std::nullopt;
+  std::optional<base::PreciseTime> deadline;
+
+  for (const auto node_index : slots[due_slot]) {
+    const auto& node = nodes[node_index];
+    if (!deadline || node.deadline < *deadline) {
+      deadline = node.deadline;
+    }
   }
 
-  return timers.begin()->deadline;
+  if (const auto tick = next_wheel_tick()) {
+    const auto tick_time = base::PreciseTime::from_nanoseconds(*tick << tick_shift);
+    if (!deadline || tick_time < *deadline) {
+      deadline = tick_time;
+    }
+  }
+
+  return deadline;
 }
 
 bool TimerManagerImpl::pending(base::PreciseTime now) const {
-  if (timers.empty()) {
-    return false;
+  if (const auto tick = next_wheel_tick(); tick && *tick <= deadline_to_tick(now)) {
+    return true;
+  }
+
+  for (const auto node_index : slots[due_slot]) {
+    if (nodes[node_index].deadline <= now) {
+      return true;
+    }
   }
 
-  return timers.begin()->deadline <= now;
+  return false;
 }
 
 }  // namespace async_net::detail
@@ -1,59 +1,104 @@
 #pragma once
+#include <async_net/Task.hpp>
+
 #include <base/macro/ClassTraits.hpp>
 #include <base/time/PreciseTime.hpp>
 
+#include <array>
 #include <cstdint>
-#include <functional>
+#include <limits>
 #include <optional>
-#include <set>
+#include <vector>
 
 namespace async_net::detail {
 
 class IoContextImpl;
 
+// Hierarchical timing wheel. Every slot holds indices of pooled timer nodes and every node knows
+// its position in the slot, so registering and unregistering a timer is O(1). Timers whose tick
+// has been reached are moved to the due slot and fire only once their exact deadline has passed
+// (in deadline order).
 class TimerManagerImpl {
-  struct TimerEntry {
-    uint64_t id{};
+  constexpr static uint32_t tick_shift = 16;
+  constexpr static uint32_t slot_bits = 6;
+  constexpr static uint32_t slot_count = 1 << slot_bits;
+  constexpr static uint32_t level_count = 6;
+
+  constexpr static uint32_t due_slot = level_count * slot_count;
+  constexpr static uint32_t invalid_slot = std::numeric_limits<uint32_t>::max();
+
+  // Callbacks are stored separately (indexed by node) to keep the nodes that are touched while
+  // cascading small.
+  struct TimerNode {
     base::PreciseTime deadline{};
-    mutable std::move_only_function<void()> callback;
-
-    bool operator<(const TimerEntry& other) const {
-      if (deadline == other.deadline) {
-        return id < other.id;
-      } else {
-        return deadline < other.deadline;
-      }
-    }
-
-    bool operator==(const TimerEntry& other) const {
-      return deadline == other.deadline && id == other.id;
-    }
+    uint64_t sequence{};
+    uint32_t generation{};
+    uint32_t slot{invalid_slot};
+    uint32_t position{};
   };
 
-  std::set<TimerEntry> timers;
-  uint64_t next_timer_id{};
+  struct FiredTimer {
+    base::PreciseTime deadline{};
+    uint64_t sequence{};
+    uint32_t node{};
+  };
+
+  std::vector<TimerNode> nodes;
+  std::vector<Task> callbacks;
+  std::vector<uint32_t> free_nodes;
+
+  std::array<std::vector<uint32_t>, level_count * slot_count + 1> slots;
+  std::array<uint64_t, level_count> occupied_slots{};
+  std::vector<uint32_t> cascaded_nodes;
+
+  uint64_t current_tick{};
+  uint64_t next_sequence{};
+  size_t active_timers{};
+
+  std::vector<FiredTimer> fired_timers;
+  std::vector<Task> pending_callbacks;
+
+  static uint64_t deadline_to_tick(base::PreciseTime deadline) {
+    return deadline.nanoseconds() >> tick_shift;
+  }
+
+  static uint64_t make_timer_id(uint32_t node, uint32_t generation) {
+    return (uint64_t(generation) << 32) | node;
+  }
+
+  void link_node(uint32_t node_index, uint32_t slot);
+  void unlink_node(uint32_t node_index);
+  void place_node(uint32_t node_index);
+
+  uint32_t allocate_node();
+  void free_node(uint32_t node_index);
+
+  void cascade_slot(uint32_t level, uint32_t slot);
+  void advance_to_tick(uint64_t tick);
 
-  std::vector<std::move_only_function<void()>> pending_callbacks;
+  std::optional<uint64_t> next_wheel_tick() const;
 
  public:
   CLASS_NON_COPYABLE_NON_MOVABLE(TimerManagerImpl)
 
-  TimerManagerImpl() = default;
+  TimerManagerImpl();
 
   struct TimerKey {
     uint64_t id{};
     base::PreciseTime deadline;
   };
 
-  TimerKey register_timer(base::PreciseTime deadline, std::move_only_function<void()> callback);
-  std::move_only_function<void()> unregister_timer(const TimerKey& key);
+  TimerKey register_timer(base::PreciseTime deadline, Task callback);
+  Task unregister_timer(const TimerKey& key);
 
   void poll(base::PreciseTime now);
   void drain();
 
+  // Returns the time at which `poll` needs to be called next. This is either the exact deadline of
+  // the earliest timer or an earlier point at which the wheel needs to cascade timers down.
   std::optional<base::PreciseTime> earliest_deadline() const;
 
-  bool empty() const { return timers.empty(); }
+  bool empty() const { return active_timers == 0; }
   bool pending(base::PreciseTime now) const;
 };
 
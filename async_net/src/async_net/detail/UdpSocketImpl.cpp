@@ -7,10 +7,12 @@
 #include <base/Log.hpp>
 #include <base/Panic.hpp>
 
+#include <algorithm>
+
 namespace async_net::detail {
 
 size_t UdpSocketImpl::send_buffer_size() const {
-  return send_buffer.size() - send_buffer_offset;
+  return send_queue.data_size();
 }
 
 size_t UdpSocketImpl::send_buffer_remaining_size() const {
@@ -23,14 +25,51 @@ size_t UdpSocketImpl::send_buffer_remaining_size() const {
   }
 }
 
+size_t UdpSocketImpl::remaining_send_budget() {
+  const auto iteration = context.impl_->current_iteration();
+  if (send_budget_iteration != iteration) {
+    send_budget_iteration = iteration;
+    iteration_datagrams_sent = 0;
+  }
+
+  // The budget might have been lowered after sending in this iteration.
+  return iteration_datagrams_sent < send_budget ? send_budget - iteration_datagrams_sent : 0;
+}
+
 bool UdpSocketImpl::is_send_buffer_full() const {
-  return send_buffer_size() >= send_buffer_max_size || send_entries.size() >= send_entries_max_size;
+  return send_buffer_size() >= send_buffer_max_size || send_queue.size() >= max_queued_datagrams;
+}
+
+bool UdpSocketImpl::has_receive_callback() const {
+  return on_data_received || on_batch_received;
+}
+
+bool UdpSocketImpl::has_send_space(size_t datagram_count, size_t size) const {
+  return send_queue.size() + datagram_count <= max_queued_datagrams &&
+         send_buffer_size() + size <= send_buffer_max_size;
+}
+
+void UdpSocketImpl::finish_queueing_send() {
+  request_poll_update();
+
+  if (flush_immediately && can_send_packets) {
+    context.impl_->queue_udp_socket_flush(this);
+  }
+}
+
+void UdpSocketImpl::request_poll_update() {
+  context.impl_->queue_poll_update(this);
+}
+
+void UdpSocketImpl::remove_poll_entry() {
+  context.impl_->remove_poll_entry(poll_entry);
 }
 
 void UdpSocketImpl::cleanup() {
   on_bound = nullptr;
   on_closed = nullptr;
   on_data_received = nullptr;
+  on_batch_received = nullptr;
   on_data_sent = nullptr;
   on_send_error = nullptr;
 }
@@ -48,6 +87,8 @@ bool UdpSocketImpl::prepare_unregister() {
   }
   unregister_pending = true;
 
+  remove_poll_entry();
+
   socket = {};
   can_send_packets = false;
 
@@ -58,6 +99,18 @@ bool UdpSocketImpl::prepare_unregister() {
   return true;
 }
 
+void UdpSocketImpl::setup_offloads(UdpSocket::BindParameters parameters) {
+  // Segmented sends fall back to separate datagrams without the offload.
+  segmentation_offload =
+    parameters.segmentation_offload && sock::DatagramSocket::is_segmentation_offload_supported();
+
+  if (parameters.receive_coalescing) {
+    if (const auto status = socket.set_receive_coalescing(true); !status) {
+      log_error("failed to enable UDP receive coalescing: {}", status.stringify());
+    }
+  }
+}
+
 void UdpSocketImpl::enter_bound_state() {
   if (const auto result = socket.local_address<SocketAddress>()) {
     local_address = result.value;
@@ -96,6 +149,7 @@ void UdpSocketImpl::bind_immediate(std::shared_ptr<UdpSocketImpl> self,
 
     if (status) {
       socket = std::move(datagram);
+      setup_offloads(parameters);
       enter_bound_state();
 
       if (state != UdpSocket::State::Shutdown) {
@@ -138,6 +192,7 @@ void UdpSocketImpl::bind_anonymous_immediate(std::shared_ptr<UdpSocketImpl> self
 
   if (status) {
     socket = std::move(datagram);
+    setup_offloads(parameters);
     enter_bound_state();
 
     if (state != UdpSocket::State::Shutdown) {
@@ -158,7 +213,11 @@ void UdpSocketImpl::bind_anonymous_immediate(std::shared_ptr<UdpSocketImpl> self
   }
 }
 
-UdpSocketImpl::UdpSocketImpl(IoContext& context) : context(context) {}
+UdpSocketImpl::UdpSocketImpl(IoContext& context) : context(context) {
+  const auto& budgets = context.impl_->io_budgets();
+  receive_budget = budgets.udp_receive_datagrams;
+  send_budget = budgets.udp_send_datagrams;
+}
 
 void UdpSocketImpl::startup(std::shared_ptr<UdpSocketImpl> self,
                             std::string hostname,
@@ -223,11 +282,13 @@ void UdpSocketImpl::shutdown(std::shared_ptr<UdpSocketImpl> self) {
 
     state = UdpSocket::State::Shutdown;
 
+    request_poll_update();
+
     if (should_unregister) {
       context.post([self = std::move(self)] {
         self->cleanup();
 
-        if (self->send_entries.empty()) {
+        if (self->send_queue.empty()) {
           if (self->prepare_unregister()) {
             self->context.impl_->unregister_udp_socket(self.get());
           }
@@ -249,25 +310,48 @@ void UdpSocketImpl::unregister_during_runloop(std::shared_ptr<UdpSocketImpl> sel
 }
 
 bool UdpSocketImpl::send_data(const SocketAddress& destination, std::span<const uint8_t> data) {
-  if (data.size() > max_datagram_size || data.size() > std::numeric_limits<uint32_t>::max()) {
+  if (data.size() > max_datagram_size) {
     return false;
   }
 
-  if ((send_entries.size() >= send_entries_max_size) ||
-      (send_buffer_size() + data.size() > send_buffer_max_size)) {
+  if (!has_send_space(1, data.size())) {
     return false;
   }
 
-  if (send_buffer_offset > 0) {
-    send_buffer.trim_front(send_buffer_offset);
-    send_buffer_offset = 0;
+  send_queue.push(destination, data);
+
+  finish_queueing_send();
+
+  return true;
+}
+
+bool UdpSocketImpl::send_segmented_data(const SocketAddress& destination,
+                                        std::span<const uint8_t> data,
+                                        size_t segment_size) {
+  if (segment_size == 0 || segment_size > max_datagram_size) {
+    return false;
   }
 
-  send_buffer.append(data);
-  send_entries.push_back({
-    .destination = destination,
-    .datagram_size = uint32_t(data.size()),
-  });
+  // Every queued datagram is sent as is unless the kernel can split it.
+  size_t queued_size = segment_size;
+  if (segmentation_offload) {
+    const auto segment_count = std::min(sock::DatagramSocket::max_send_segments,
+                                        max_segmented_send_size / segment_size);
+    queued_size = std::max<size_t>(segment_count, 1) * segment_size;
+  }
+
+  const auto datagram_count = (data.size() + queued_size - 1) / queued_size;
+  if (!has_send_space(datagram_count, data.size())) {
+    return false;
+  }
+
+  for (size_t offset = 0; offset < data.size(); offset += queued_size) {
+    const auto datagram = data.subspan(offset, std::min(queued_size, data.size() - offset));
+    send_queue.push(destination, datagram,
+                    uint16_t(datagram.size() > segment_size ? segment_size : 0));
+  }
+
+  finish_queueing_send();
 
   return true;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "Common.hpp"
+#include "DatagramQueue.hpp"
 
 #include <async_net/IpAddress.hpp>
 #include <async_net/Status.hpp>
@@ -7,8 +8,6 @@
 
 #include <socklib/Socket.hpp>
 
-#include <base/containers/BinaryBuffer.hpp>
-
 #include <functional>
 #include <vector>
 
@@ -27,16 +26,14 @@ class UdpSocketImpl {
   friend IoContextImpl;
   friend ContextEntryRegistration;
 
-  constexpr static size_t send_entries_max_size = 32 * 1024;
-
-  struct SendEntry {
-    SocketAddress destination;
-    uint32_t datagram_size{};
-  };
+  constexpr static size_t max_queued_datagrams = 32 * 1024;
 
   IoContext& context;
   size_t context_index{invalid_context_index};
 
+  sock::Poller::PollEntry poll_entry{};
+  bool poll_update_pending{};
+
   UdpSocket::State state{UdpSocket::State::Binding};
   bool unregister_pending{};
   bool can_send_packets{};
@@ -45,12 +42,19 @@ class UdpSocketImpl {
 
   bool receive_packets{true};
 
-  base::BinaryBuffer send_buffer;
-  size_t send_buffer_offset{};
+  DatagramQueue send_queue;
   size_t send_buffer_max_size{default_send_buffer_max_size};
   bool block_on_send_buffer_full{true};
+  bool flush_immediately{};
+  bool flush_pending{};
+  bool segmentation_offload{};
 
-  std::vector<SendEntry> send_entries;
+  // Per-iteration limits in datagrams (see `IoContext::IoBudgets`). Datagrams sent by flushes and
+  // writability events of the same iteration (`send_budget_iteration`) share the send budget.
+  size_t receive_budget{};
+  size_t send_budget{};
+  uint64_t send_budget_iteration{};
+  size_t iteration_datagrams_sent{};
 
   SocketAddress local_address{};
   uint64_t total_bytes_received{};
@@ -59,17 +63,27 @@ class UdpSocketImpl {
   std::move_only_function<void(Status)> on_bound;
   std::move_only_function<void(Status)> on_closed;
   std::move_only_function<void(const SocketAddress&, std::span<const uint8_t>)> on_data_received;
+  std::move_only_function<void(std::span<const UdpSocket::ReceivedDatagram>)> on_batch_received;
   std::move_only_function<void()> on_data_sent;
   std::move_only_function<void(Status)> on_send_error;
 
   size_t send_buffer_size() const;
   size_t send_buffer_remaining_size() const;
+  size_t remaining_send_budget();
   bool is_send_buffer_full() const;
+  bool has_receive_callback() const;
+  bool has_send_space(size_t datagram_count, size_t size) const;
+
+  void finish_queueing_send();
+
+  void request_poll_update();
+  void remove_poll_entry();
 
   void cleanup();
   void cleanup_before_register();
   bool prepare_unregister();
 
+  void setup_offloads(UdpSocket::BindParameters parameters);
   void enter_bound_state();
 
   void bind_immediate(std::shared_ptr<UdpSocketImpl> self,
@@ -98,6 +112,9 @@ class UdpSocketImpl {
   void unregister_during_runloop(std::shared_ptr<UdpSocketImpl> self);
 
   bool send_data(const SocketAddress& destination, std::span<const uint8_t> data);
+  bool send_segmented_data(const SocketAddress& destination,
+                           std::span<const uint8_t> data,
+                           size_t segment_size);
 };
 
 }  // namespace detail
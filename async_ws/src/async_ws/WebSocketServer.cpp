@@ -3,24 +3,32 @@
 
 namespace async_ws {
 
-WebSocketServer::WebSocketServer(async_net::IoContext& context, std::string hostname, uint16_t port)
-    : impl_(std::make_shared<detail::WebSocketServerImpl>(context, std::move(hostname), port)) {
+WebSocketServer::WebSocketServer(async_net::IoContext& context,
+                                 std::string hostname,
+                                 uint16_t port,
+                                 BindParameters parameters)
+    : impl_(std::make_shared<detail::WebSocketServerImpl>(context, std::move(hostname), port,
+                                                          parameters)) {
   impl_->startup(impl_);
 }
 
 WebSocketServer::WebSocketServer(async_net::IoContext& context,
-                                 const async_net::SocketAddress& address)
-    : impl_(std::make_shared<detail::WebSocketServerImpl>(context, address)) {
+                                 const async_net::SocketAddress& address,
+                                 BindParameters parameters)
+    : impl_(std::make_shared<detail::WebSocketServerImpl>(context, address, parameters)) {
   impl_->startup(impl_);
 }
 
 WebSocketServer::WebSocketServer(async_net::IoContext& context,
                                  const async_net::IpAddress& address,
-                                 uint16_t port)
-    : WebSocketServer(context, async_net::SocketAddress{address, port}) {}
+                                 uint16_t port,
+                                 BindParameters parameters)
+    : WebSocketServer(context, async_net::SocketAddress{address, port}, parameters) {}
 
-WebSocketServer::WebSocketServer(async_net::IoContext& context, uint16_t port)
-    : WebSocketServer(context, async_net::IpAddress::unspecified(), port) {}
+WebSocketServer::WebSocketServer(async_net::IoContext& context,
+                                 uint16_t port,
+                                 BindParameters parameters)
+    : WebSocketServer(context, async_net::IpAddress::unspecified(), port, parameters) {}
 
 WebSocketServer::~WebSocketServer() {
   if (impl_) {
@@ -9,6 +9,7 @@
 #include <async_net/IoContext.hpp>
 #include <async_net/IpAddress.hpp>
 #include <async_net/Status.hpp>
+#include <async_net/TcpListener.hpp>
 
 #include <base/macro/ClassTraits.hpp>
 
@@ -31,16 +32,26 @@ class WebSocketServer {
     Shutdown,
   };
 
+  using BindParameters = async_net::TcpListener::BindParameters;
+
   CLASS_NON_COPYABLE(WebSocketServer)
 
   WebSocketServer() = default;
 
-  WebSocketServer(async_net::IoContext& context, std::string hostname, uint16_t port);
-  WebSocketServer(async_net::IoContext& context, const async_net::SocketAddress& address);
+  WebSocketServer(async_net::IoContext& context,
+                  std::string hostname,
+                  uint16_t port,
+                  BindParameters parameters = BindParameters::default_parameters());
+  WebSocketServer(async_net::IoContext& context,
+                  const async_net::SocketAddress& address,
+                  BindParameters parameters = BindParameters::default_parameters());
   WebSocketServer(async_net::IoContext& context,
                   const async_net::IpAddress& address,
-                  uint16_t port);
-  WebSocketServer(async_net::IoContext& context, uint16_t port);
+                  uint16_t port,
+                  BindParameters parameters = BindParameters::default_parameters());
+  WebSocketServer(async_net::IoContext& context,
+                  uint16_t port,
+                  BindParameters parameters = BindParameters::default_parameters());
   ~WebSocketServer();
 
   WebSocketServer(WebSocketServer&& other) noexcept;
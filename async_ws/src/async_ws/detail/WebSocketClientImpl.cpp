@@ -13,6 +13,7 @@ namespace async_ws::detail {
 
 constexpr static size_t max_packet_size = 64 * 1024 * 1024;
 constexpr static size_t max_message_size = 128 * 1024 * 1024;
+constexpr static size_t min_vectored_payload_size = 4 * 1024;
 
 std::optional<websocket::MaskingKey> WebSocketClientImpl::generate_masking_key_if_needed() {
   if (masking_settings.send_masked) {
@@ -80,6 +81,23 @@ void WebSocketClientImpl::send_queued_ping_pongs() {
 bool WebSocketClientImpl::send_packet(const websocket::Packet& packet,
                                       std::span<const uint8_t> payload,
                                       bool force) {
+  // Unmasked payloads are sent as is so large ones don't need to be copied next to the header.
+  if (!packet.masking_key && payload.size() >= min_vectored_payload_size) {
+    if (!force && websocket::Serializer::serialized_packet_size(payload.size(), false) >
+                    connection.send_buffer_remaining_size()) {
+      return false;
+    }
+
+    const auto header = websocket::Serializer::serialize_header(packet, payload.size());
+    const std::array<std::span<const uint8_t>, 2> slices{header.span(), payload};
+
+    if (force) {
+      return connection.send_data_vectored_force(slices);
+    } else {
+      return connection.send_data_vectored(slices);
+    }
+  }
+
   if (force) {
     return connection.send_force([&](base::BinaryBuffer& buffer) {
       websocket::Serializer::serialize(packet, payload, buffer);
@@ -23,12 +23,14 @@ void WebSocketServerImpl::cleanup_deferred(std::shared_ptr<WebSocketServerImpl>
 
 WebSocketServerImpl::WebSocketServerImpl(async_net::IoContext& context,
                                          std::string hostname,
-                                         uint16_t port)
-    : context(context), listener(context, std::move(hostname), port) {}
+                                         uint16_t port,
+                                         WebSocketServer::BindParameters parameters)
+    : context(context), listener(context, std::move(hostname), port, parameters) {}
 
 WebSocketServerImpl::WebSocketServerImpl(async_net::IoContext& context,
-                                         const async_net::SocketAddress& address)
-    : context(context), listener(context, address) {}
+                                         const async_net::SocketAddress& address,
+                                         WebSocketServer::BindParameters parameters)
+    : context(context), listener(context, address, parameters) {}
 
 async_net::IoContext& WebSocketServerImpl::io_context() {
   return context;
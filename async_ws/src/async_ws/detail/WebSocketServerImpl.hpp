@@ -34,8 +34,13 @@ class WebSocketServerImpl {
   void cleanup_deferred(std::shared_ptr<WebSocketServerImpl> self);
 
  public:
-  WebSocketServerImpl(async_net::IoContext& context, std::string hostname, uint16_t port);
-  WebSocketServerImpl(async_net::IoContext& context, const async_net::SocketAddress& address);
+  WebSocketServerImpl(async_net::IoContext& context,
+                      std::string hostname,
+                      uint16_t port,
+                      WebSocketServer::BindParameters parameters);
+  WebSocketServerImpl(async_net::IoContext& context,
+                      const async_net::SocketAddress& address,
+                      WebSocketServer::BindParameters parameters);
 
   WebSocketServer::State state() const { return state_; }
 
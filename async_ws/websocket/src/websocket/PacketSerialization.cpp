@@ -137,8 +137,19 @@ struct WebsocketPacketReader {
   }
 };
 
+struct HeaderOutput {
+  Serializer::Header& header;
+
+  void append(std::span<const uint8_t> bytes) {
+    verify(header.size + bytes.size() <= header.data.size(), "packet header is too large");
+    std::memcpy(header.data.data() + header.size, bytes.data(), bytes.size());
+    header.size += bytes.size();
+  }
+};
+
+template <typename Output>
 struct WebsocketPacketWriter {
-  base::BinaryBuffer& buffer;
+  Output& buffer;
 
   template <size_t N>
   void write_bytes(const std::array<uint8_t, N>& bytes) {
@@ -168,7 +179,7 @@ struct WebsocketPacketWriter {
     write_bytes(buffer);
   }
 
-  void run(const Packet& packet, std::span<const uint8_t> payload) {
+  void write_header(const Packet& packet, size_t payload_size) {
     uint8_t field1{};
     if (packet.final) {
       field1 |= (1 << 7);
@@ -182,7 +193,6 @@ struct WebsocketPacketWriter {
       field2 |= (1 << 7);
     }
 
-    const auto payload_size = payload.size();
     if (payload_size <= 125) {
       field2 |= uint8_t(payload_size);
       write_u8(field2);
@@ -202,6 +212,10 @@ struct WebsocketPacketWriter {
     if (packet.masking_key) {
       write_bytes(*packet.masking_key);
     }
+  }
+
+  void run(const Packet& packet, std::span<const uint8_t> payload) {
+    write_header(packet, payload.size());
 
     if (!payload.empty()) {
       const auto size_before = buffer.size();
@@ -218,12 +232,24 @@ struct WebsocketPacketWriter {
 void Serializer::serialize(const Packet& packet,
                            std::span<const uint8_t> payload,
                            base::BinaryBuffer& buffer) {
-  WebsocketPacketWriter writer{
+  WebsocketPacketWriter<base::BinaryBuffer> writer{
     .buffer = buffer,
   };
   writer.run(packet, payload);
 }
 
+Serializer::Header Serializer::serialize_header(const Packet& packet, size_t payload_size) {
+  Header header{};
+  HeaderOutput output{
+    .header = header,
+  };
+  WebsocketPacketWriter<HeaderOutput> writer{
+    .buffer = output,
+  };
+  writer.write_header(packet, payload_size);
+  return header;
+}
+
 size_t Serializer::serialized_packet_size(size_t payload_size, bool masked) {
   size_t packet_size = 2;
   if (payload_size > 125) {
@@ -7,10 +7,23 @@ namespace websocket {
 
 class Serializer {
  public:
+  constexpr static size_t max_header_size = 14;
+
+  struct Header {
+    std::array<uint8_t, max_header_size> data{};
+    size_t size{};
+
+    std::span<const uint8_t> span() const { return {data.data(), size}; }
+  };
+
   static void serialize(const Packet& packet,
                         std::span<const uint8_t> payload,
                         base::BinaryBuffer& buffer);
 
+  // Serializes only the packet header. The payload of an unmasked packet can be sent right after it
+  // as is.
+  static Header serialize_header(const Packet& packet, size_t payload_size);
+
   static size_t serialized_packet_size(size_t payload_size, bool masked);
 };
 
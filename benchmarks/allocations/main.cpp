@@ -0,0 +1,250 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+#include <async_net/Timer.hpp>
+
+#include <async_ws/WebSocketClient.hpp>
+#include <async_ws/WebSocketServer.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <vector>
+
+// Counts heap allocations done by the library on hot paths: echo round trips over TCP and
+// WebSocket connections, posting deferred work and scheduling timers.
+
+static std::atomic_uint64_t allocation_count{};
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (const auto pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+// Counts allocations between the warmup and the end of the measured operations.
+class AllocationCounter {
+  std::optional<uint64_t> start_count;
+
+ public:
+  void start() { start_count = allocation_count.load(std::memory_order_relaxed); }
+
+  void finish(std::string_view operation, size_t operations) {
+    verify(start_count, "allocation counter wasn't started");
+
+    const auto allocations = allocation_count.load(std::memory_order_relaxed) - *start_count;
+    log_info("{:<24} {:.3f} allocations per operation", operation,
+             double(allocations) / double(operations));
+  }
+};
+
+constexpr uint16_t port = 44447;
+constexpr size_t message_size = 64;
+constexpr size_t warmup_round_trips = 1'000;
+constexpr size_t round_trips = 100'000;
+
+static void benchmark_tcp_echo() {
+  async_net::IoContext context;
+
+  async_net::TcpListener listener{context, async_net::IpAddress::loopback(), port};
+  std::unique_ptr<async_net::TcpConnection> server_connection;
+
+  listener.set_on_accept([&](async_net::Status status, async_net::TcpConnection connection) {
+    verify(status, "failed to accept connection: {}", status.stringify());
+
+    server_connection = std::make_unique<async_net::TcpConnection>(std::move(connection));
+    server_connection->set_on_data_received([&](std::span<const uint8_t> data) {
+      verify(server_connection->send_data(data), "failed to send data");
+      return data.size();
+    });
+  });
+
+  async_net::TcpConnection client{context, async_net::IpAddress::loopback(), port};
+
+  const std::vector<uint8_t> message(message_size);
+
+  size_t completed_round_trips = 0;
+  AllocationCounter counter;
+
+  client.set_on_connected([&](async_net::Status status) {
+    verify(status, "failed to connect: {}", status.stringify());
+    verify(client.send_data(message), "failed to send data");
+  });
+
+  client.set_on_data_received([&](std::span<const uint8_t> data) {
+    if (data.size() < message_size) {
+      return size_t(0);
+    }
+
+    completed_round_trips++;
+    if (completed_round_trips == warmup_round_trips) {
+      counter.start();
+    }
+
+    if (completed_round_trips == warmup_round_trips + round_trips) {
+      counter.finish("tcp echo round trip", round_trips);
+
+      client.shutdown();
+      server_connection = nullptr;
+      listener.shutdown();
+    } else {
+      verify(client.send_data(message), "failed to send data");
+    }
+
+    return message_size;
+  });
+
+  verify(context.run_until_no_work(), "run failed");
+}
+
+static void benchmark_websocket_echo() {
+  async_net::IoContext context;
+
+  async_ws::WebSocketServer server{context, async_net::IpAddress::loopback(), port};
+  std::unique_ptr<async_ws::WebSocketClient> server_client;
+
+  async_ws::WebSocketClient client;
+
+  const std::vector<uint8_t> message(message_size);
+
+  size_t completed_round_trips = 0;
+  AllocationCounter counter;
+
+  server.set_on_error([](async_ws::Status status) {
+    fatal_error("failed to start the server: {}", status.stringify());
+  });
+  server.set_on_client_connected([&](std::string_view uri, async_ws::WebSocketClient client) {
+    server_client = std::make_unique<async_ws::WebSocketClient>(std::move(client));
+    server_client->set_on_binary_message_received([&](std::span<const uint8_t> data) {
+      verify(server_client->send_binary_message(data), "failed to send message");
+    });
+  });
+
+  server.set_on_listening([&] {
+    client = async_ws::WebSocketClient{context, "::1", port, "/"};
+
+    client.set_on_connected([&](async_ws::Status status) {
+      verify(status, "failed to connect: {}", status.stringify());
+      verify(client.send_binary_message(message), "failed to send message");
+    });
+
+    client.set_on_binary_message_received([&](std::span<const uint8_t> data) {
+      completed_round_trips++;
+      if (completed_round_trips == warmup_round_trips) {
+        counter.start();
+      }
+
+      if (completed_round_trips == warmup_round_trips + round_trips) {
+        counter.finish("websocket echo round trip", round_trips);
+
+        client.shutdown();
+        server_client = nullptr;
+        server.shutdown();
+      } else {
+        verify(client.send_binary_message(message), "failed to send message");
+      }
+    });
+  });
+
+  verify(context.run_until_no_work(), "run failed");
+}
+
+static void benchmark_post() {
+  constexpr size_t posts = 100'000;
+
+  async_net::IoContext context;
+
+  // Typical deferred work: an object reference plus a few values.
+  const auto object = std::make_shared<uint64_t>();
+  std::array<uint64_t, 3> values{};
+
+  AllocationCounter counter;
+  counter.start();
+
+  for (size_t i = 0; i < posts; ++i) {
+    context.post([object, values] { *object += values[0]; });
+  }
+  verify(context.run_until_no_work(), "run failed");
+
+  counter.finish("post", posts);
+}
+
+static void benchmark_post_atomic() {
+  constexpr size_t posts = 100'000;
+
+  async_net::IoContext context;
+
+  const auto object = std::make_shared<uint64_t>();
+  std::array<uint64_t, 3> values{};
+
+  // Let the queue allocate its nodes first.
+  for (size_t i = 0; i < posts; ++i) {
+    context.post_atomic([] {});
+  }
+  // Posting wakes the context up, so this doesn't block.
+  verify(context.run({}) == async_net::IoContext::RunResult::Ok, "run failed");
+
+  AllocationCounter counter;
+  counter.start();
+
+  for (size_t i = 0; i < posts; ++i) {
+    context.post_atomic([object, values] { *object += values[0]; });
+  }
+  // Posting wakes the context up, so this doesn't block.
+  verify(context.run({}) == async_net::IoContext::RunResult::Ok, "run failed");
+
+  counter.finish("atomic post", posts);
+}
+
+static void benchmark_timers() {
+  constexpr size_t timers = 100'000;
+
+  async_net::IoContext context;
+
+  const auto object = std::make_shared<uint64_t>();
+  std::array<uint64_t, 3> values{};
+
+  // Let the timer wheel allocate its slots first.
+  for (size_t i = 0; i < timers; ++i) {
+    async_net::Timer::invoke_after_detached(context, {}, [] {});
+  }
+  verify(context.run_until_no_work(), "run failed");
+
+  AllocationCounter counter;
+  counter.start();
+
+  for (size_t i = 0; i < timers; ++i) {
+    async_net::Timer::invoke_after_detached(context, {},
+                                            [object, values] { *object += values[0]; });
+  }
+  verify(context.run_until_no_work(), "run failed");
+
+  counter.finish("detached timer", timers);
+}
+
+int main() {
+  base::initialize();
+
+  benchmark_tcp_echo();
+  benchmark_websocket_echo();
+  benchmark_post();
+  benchmark_post_atomic();
+  benchmark_timers();
+}
@@ -0,0 +1,123 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/SharedBuffer.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Measures publishing the same message to many subscribers, copying it to every connection's send
+// buffer versus queuing one shared buffer on all of them.
+
+constexpr uint16_t port = 44449;
+constexpr size_t subscriber_count = 128;
+constexpr size_t message_size = 16 * 1024;
+constexpr size_t message_count = 500;
+// Number of messages the publisher can be ahead of the slowest subscriber.
+constexpr size_t publish_window = 8;
+
+enum class PublishMode {
+  Copy,
+  Shared,
+};
+
+static void run_benchmark(std::string_view name, PublishMode mode) {
+  async_net::IoContext context;
+
+  async_net::TcpListener listener{
+    context, async_net::IpAddress::loopback(), port, {.max_pending_connections = subscriber_count}};
+  std::vector<std::unique_ptr<async_net::TcpConnection>> publisher_connections;
+
+  const std::vector<uint8_t> message(message_size);
+
+  // Number of subscribers which have received each message.
+  std::vector<size_t> message_receive_counts(message_count);
+  size_t messages_published = 0;
+  size_t messages_fully_received = 0;
+
+  const auto publish = [&] {
+    while (messages_published < message_count &&
+           messages_published < messages_fully_received + publish_window) {
+      if (mode == PublishMode::Copy) {
+        for (auto& connection : publisher_connections) {
+          connection->send_data_force(message);
+        }
+      } else {
+        const auto shared_message = async_net::SharedBuffer::copy(message);
+        for (auto& connection : publisher_connections) {
+          connection->send_shared_force(shared_message);
+        }
+      }
+
+      messages_published++;
+    }
+  };
+
+  listener.set_on_accept([&](async_net::Status status, async_net::TcpConnection connection) {
+    verify(status, "failed to accept connection: {}", status.stringify());
+
+    auto& publisher_connection = publisher_connections.emplace_back(
+      std::make_unique<async_net::TcpConnection>(std::move(connection)));
+    publisher_connection->set_max_send_buffer_size(std::numeric_limits<size_t>::max());
+
+    if (publisher_connections.size() == subscriber_count) {
+      publish();
+    }
+  });
+
+  std::vector<std::unique_ptr<async_net::TcpConnection>> subscribers;
+  std::vector<uint64_t> subscriber_bytes_received(subscriber_count);
+
+  for (size_t i = 0; i < subscriber_count; ++i) {
+    auto& subscriber = *subscribers.emplace_back(std::make_unique<async_net::TcpConnection>(
+      context, async_net::IpAddress::loopback(), port));
+
+    subscriber.set_on_connected([](async_net::Status status) {
+      verify(status, "failed to connect: {}", status.stringify());
+    });
+    subscriber.set_on_data_received([&, i](std::span<const uint8_t> data) {
+      auto& bytes_received = subscriber_bytes_received[i];
+
+      const auto messages_before = bytes_received / message_size;
+      bytes_received += data.size();
+      const auto messages_after = bytes_received / message_size;
+
+      for (auto message = messages_before; message < messages_after; ++message) {
+        message_receive_counts[message]++;
+      }
+
+      while (messages_fully_received < message_count &&
+             message_receive_counts[messages_fully_received] == subscriber_count) {
+        messages_fully_received++;
+      }
+
+      publish();
+
+      return data.size();
+    });
+  }
+
+  base::Stopwatch stopwatch;
+  while (messages_fully_received < message_count) {
+    verify(context.run({}) == async_net::IoContext::RunResult::Ok, "failed to run IO context");
+  }
+  const auto elapsed = stopwatch.elapsed();
+
+  const auto bytes_delivered = double(message_count * message_size * subscriber_count);
+  log_info("{}: {} ({:.0f} MB/s delivered)", name, elapsed,
+           bytes_delivered / elapsed.seconds() / 1'000'000.0);
+}
+
+int main() {
+  base::initialize();
+
+  run_benchmark("copy per subscriber", PublishMode::Copy);
+  run_benchmark("shared buffer", PublishMode::Shared);
+}
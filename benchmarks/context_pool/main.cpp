@@ -0,0 +1,186 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/concurrency/CoreCount.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContextPool.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Measures echo throughput of a server running on an IoContextPool. Connections are distributed
+// between server threads either by SO_REUSEPORT listeners in every context or by a single listener
+// handing them off. Clients run on a separate pool with the same number of threads.
+
+constexpr uint16_t port = 44446;
+constexpr size_t message_size = 64;
+
+enum class Distribution {
+  ReusePort,
+  HandoffRoundRobin,
+  HandoffLeastConnections,
+};
+
+static std::string_view distribution_name(Distribution distribution) {
+  switch (distribution) {
+    case Distribution::ReusePort:
+      return "reuse port";
+    case Distribution::HandoffRoundRobin:
+      return "handoff (round robin)";
+    case Distribution::HandoffLeastConnections:
+      return "handoff (least connections)";
+  }
+  return "";
+}
+
+struct ServerShard {
+  async_net::TcpListener listener;
+  std::vector<std::unique_ptr<async_net::TcpConnection>> connections;
+};
+
+static void serve_echo(ServerShard& shard, async_net::TcpConnection connection) {
+  auto& server_connection = shard.connections.emplace_back(
+    std::make_unique<async_net::TcpConnection>(std::move(connection)));
+  server_connection->set_on_data_received(
+    [connection = server_connection.get()](std::span<const uint8_t> data) {
+      verify(connection->send_data(data), "failed to send data");
+      return data.size();
+    });
+}
+
+struct ClientShard {
+  std::vector<async_net::TcpConnection> connections;
+  uint64_t round_trips{};
+};
+
+static void run_benchmark(Distribution distribution,
+                          size_t thread_count,
+                          size_t connections_per_thread,
+                          base::PreciseTime duration) {
+  async_net::IoContextPool server_pool{{.context_count = thread_count}};
+  async_net::IoContextPool client_pool{{.context_count = thread_count}};
+
+  std::vector<ServerShard> server_shards(thread_count);
+  std::vector<ClientShard> client_shards(thread_count);
+
+  const size_t listener_count = distribution == Distribution::ReusePort ? thread_count : 1;
+  std::atomic_size_t listening_count{};
+
+  for (size_t i = 0; i < listener_count; ++i) {
+    auto& shard = server_shards[i];
+
+    shard.listener = async_net::TcpListener{server_pool.context(i),
+                                            async_net::IpAddress::loopback(),
+                                            port,
+                                            {
+                                              .reuse_port = true,
+                                              .max_pending_connections = 1024,
+                                            }};
+    shard.listener.set_on_listening([&] { listening_count++; });
+
+    if (distribution == Distribution::ReusePort) {
+      shard.listener.set_on_accept(
+        [&](async_net::Status status, async_net::TcpConnection connection) {
+          verify(status, "failed to accept connection: {}", status.stringify());
+          serve_echo(shard, std::move(connection));
+        });
+    } else {
+      const auto policy = distribution == Distribution::HandoffRoundRobin
+                            ? async_net::TcpListener::HandoffPolicy::RoundRobin
+                            : async_net::TcpListener::HandoffPolicy::LeastConnections;
+
+      // Called on the thread of the target context.
+      shard.listener.set_on_accept_handoff(
+        server_pool, policy, [&](async_net::TcpConnection connection) {
+          for (size_t j = 0; j < thread_count; ++j) {
+            if (connection.io_context() == &server_pool.context(j)) {
+              return serve_echo(server_shards[j], std::move(connection));
+            }
+          }
+          fatal_error("connection was handed off to an unknown context");
+        });
+    }
+  }
+
+  server_pool.start();
+
+  while (listening_count < listener_count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  const std::vector<uint8_t> message(message_size);
+
+  for (size_t i = 0; i < thread_count; ++i) {
+    auto& shard = client_shards[i];
+    shard.connections.reserve(connections_per_thread);
+
+    for (size_t j = 0; j < connections_per_thread; ++j) {
+      auto& connection = shard.connections.emplace_back(
+        client_pool.context(i), async_net::IpAddress::loopback(), port);
+
+      connection.set_on_connected([&](async_net::Status status) {
+        verify(status, "failed to connect: {}", status.stringify());
+        verify(connection.send_data(message), "failed to send data");
+      });
+      connection.set_on_data_received([&](std::span<const uint8_t> data) {
+        if (data.size() < message_size) {
+          return size_t(0);
+        }
+
+        shard.round_trips++;
+        verify(connection.send_data(message), "failed to send data");
+
+        return message_size;
+      });
+    }
+  }
+
+  base::Stopwatch stopwatch;
+
+  client_pool.start();
+  std::this_thread::sleep_for(std::chrono::nanoseconds(duration.nanoseconds()));
+  verify(client_pool.stop(), "client pool failed");
+
+  const auto elapsed = stopwatch.elapsed();
+
+  verify(server_pool.stop(), "server pool failed");
+
+  uint64_t total_round_trips = 0;
+  for (const auto& shard : client_shards) {
+    total_round_trips += shard.round_trips;
+  }
+
+  log_info("{}, {:>2} threads: {:.0f} round trips/s", distribution_name(distribution),
+           thread_count, double(total_round_trips) / elapsed.seconds());
+
+  const auto stats = server_pool.stats();
+  for (size_t i = 0; i < stats.size(); ++i) {
+    log_info("  server thread {:>2}: {:>4} connections, {:>8} iterations, {} waiting in poll", i,
+             stats[i].tcp_connections, stats[i].iterations, stats[i].poll_wait_time);
+  }
+}
+
+int main() {
+  base::initialize();
+
+  // Server and client pools use the same number of threads.
+  const size_t max_thread_count = std::max<size_t>(base::core_count() / 2, 1);
+
+  const size_t connections_per_thread = 16;
+  const auto duration = base::PreciseTime::from_seconds(2.0);
+
+  for (const auto distribution : {Distribution::ReusePort, Distribution::HandoffRoundRobin,
+                                  Distribution::HandoffLeastConnections}) {
+    for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+      run_benchmark(distribution, thread_count, connections_per_thread, duration);
+    }
+  }
+}
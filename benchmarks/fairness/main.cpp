@@ -0,0 +1,152 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Measures round-trip latency of interactive connections sharing a context with bulk transfers,
+// with different per-iteration IO budgets.
+
+constexpr uint16_t port = 44448;
+constexpr size_t message_size = 64;
+constexpr size_t bulk_chunk_size = 1024 * 1024;
+constexpr size_t bulk_connection_count = 2;
+constexpr size_t interactive_connection_count = 16;
+
+struct InteractiveClient {
+  async_net::TcpConnection connection;
+  base::PreciseTime send_time;
+};
+
+static void run_benchmark(std::string_view name,
+                          const async_net::IoContext::IoBudgets& budgets,
+                          base::PreciseTime duration) {
+  async_net::IoContext context{{.io_budgets = budgets}};
+
+  async_net::TcpListener listener{
+    context, async_net::IpAddress::loopback(), port, {.max_pending_connections = 64}};
+  std::vector<std::unique_ptr<async_net::TcpConnection>> server_connections;
+
+  // Server echoes everything back. Bulk clients discard the echoed data.
+  listener.set_on_accept([&](async_net::Status status, async_net::TcpConnection connection) {
+    verify(status, "failed to accept connection: {}", status.stringify());
+
+    auto& server_connection = server_connections.emplace_back(
+      std::make_unique<async_net::TcpConnection>(std::move(connection)));
+    server_connection->set_max_send_buffer_size(std::numeric_limits<size_t>::max());
+    server_connection->set_on_data_received(
+      [connection = server_connection.get()](std::span<const uint8_t> data) {
+        verify(connection->send_data(data), "failed to send data");
+        return data.size();
+      });
+  });
+
+  const std::vector<uint8_t> bulk_chunk(bulk_chunk_size);
+  const std::vector<uint8_t> message(message_size);
+
+  uint64_t bulk_bytes_received = 0;
+  std::vector<base::PreciseTime> latencies;
+
+  std::vector<std::unique_ptr<async_net::TcpConnection>> bulk_clients;
+  for (size_t i = 0; i < bulk_connection_count; ++i) {
+    auto& client = *bulk_clients.emplace_back(std::make_unique<async_net::TcpConnection>(
+      context, async_net::IpAddress::loopback(), port));
+
+    // Keep a few chunks queued all the time.
+    const auto refill = [&client, &bulk_chunk] {
+      while (client.pending_to_send() < 4 * bulk_chunk_size) {
+        client.send_data_force(bulk_chunk);
+      }
+    };
+
+    client.set_on_connected([refill](async_net::Status status) {
+      verify(status, "failed to connect: {}", status.stringify());
+      refill();
+    });
+    client.set_on_data_sent(refill);
+    client.set_on_data_received([&](std::span<const uint8_t> data) {
+      bulk_bytes_received += data.size();
+      return data.size();
+    });
+  }
+
+  std::vector<std::unique_ptr<InteractiveClient>> interactive_clients;
+  for (size_t i = 0; i < interactive_connection_count; ++i) {
+    auto& client = *interactive_clients.emplace_back(std::make_unique<InteractiveClient>(
+      async_net::TcpConnection{context, async_net::IpAddress::loopback(), port}));
+
+    const auto send_message = [&client, &message] {
+      client.send_time = base::PreciseTime::now();
+      verify(client.connection.send_data(message), "failed to send data");
+    };
+
+    client.connection.set_on_connected([send_message](async_net::Status status) {
+      verify(status, "failed to connect: {}", status.stringify());
+      send_message();
+    });
+    client.connection.set_on_data_received([&, send_message](std::span<const uint8_t> data) {
+      if (data.size() < message_size) {
+        return size_t(0);
+      }
+
+      latencies.push_back(base::PreciseTime::now() - client.send_time);
+      send_message();
+
+      return message_size;
+    });
+  }
+
+  base::Stopwatch stopwatch;
+  while (stopwatch.elapsed() < duration) {
+    verify(context.run({.timeout = duration}) == async_net::IoContext::RunResult::Ok,
+           "failed to run IO context");
+  }
+  const auto elapsed = stopwatch.elapsed();
+
+  verify(!latencies.empty(), "no round trips were completed");
+  std::sort(latencies.begin(), latencies.end());
+
+  const auto percentile = [&](double p) {
+    return latencies[std::min(latencies.size() - 1, size_t(double(latencies.size()) * p))];
+  };
+
+  log_info("{}: {:.0f} MB/s bulk, {} round trips, p50 {}, p99 {}, max {}", name,
+           double(bulk_bytes_received) / elapsed.seconds() / 1'000'000.0, latencies.size(),
+           percentile(0.5), percentile(0.99), latencies.back());
+}
+
+int main() {
+  base::initialize();
+
+  const auto duration = base::PreciseTime::from_seconds(2.0);
+
+  // Limits used before per-iteration budgets were configurable.
+  run_benchmark("legacy limits",
+                {
+                  .tcp_receive_bytes = 16 * 1024 * 1024,
+                  .tcp_send_bytes = std::numeric_limits<size_t>::max(),
+                },
+                duration);
+  run_benchmark("default budgets", {}, duration);
+  run_benchmark("1 MiB budgets",
+                {
+                  .tcp_receive_bytes = 1024 * 1024,
+                  .tcp_send_bytes = 1024 * 1024,
+                },
+                duration);
+  run_benchmark("64 KiB budgets",
+                {
+                  .tcp_receive_bytes = 64 * 1024,
+                  .tcp_send_bytes = 64 * 1024,
+                },
+                duration);
+}
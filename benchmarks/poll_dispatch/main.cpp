@@ -0,0 +1,103 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/UdpSocket.hpp>
+
+#include <socklib/Socket.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+// Measures how long one IoContext iteration takes when only 1% of registered sockets are
+// signaled. Dispatch cost should depend on the number of active sockets, not on the total count.
+
+static void raise_file_limit() {
+#if !defined(_WIN32)
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    (void)setrlimit(RLIMIT_NOFILE, &limit);
+  }
+#endif
+}
+
+static void run_benchmark(size_t socket_count, size_t iterations) {
+  async_net::IoContext context;
+
+  size_t failed_binds = 0;
+  size_t received_datagrams = 0;
+
+  std::vector<async_net::UdpSocket> sockets;
+  sockets.reserve(socket_count);
+  for (size_t i = 0; i < socket_count; ++i) {
+    auto& socket = sockets.emplace_back(context, async_net::IpAddress::loopback(), 0);
+    socket.set_on_bound([&](async_net::Status status) {
+      if (!status) {
+        failed_binds++;
+      }
+    });
+    socket.set_on_data_received(
+      [&](const async_net::SocketAddress&, std::span<const uint8_t>) { received_datagrams++; });
+  }
+
+  // Binding is deferred to the first iteration.
+  verify(context.run({.timeout = base::PreciseTime{}}) == async_net::IoContext::RunResult::Ok,
+         "run failed");
+
+  if (failed_binds > 0) {
+    log_error("{} sockets: failed to bind {} sockets (file descriptor limit?)", socket_count,
+              failed_binds);
+    return;
+  }
+
+  auto [status, sender] = sock::DatagramSocket::bind(
+    async_net::SocketAddress{async_net::IpAddress::loopback(), 0});
+  verify(status, "failed to create sender socket: {}", status.stringify());
+
+  const size_t active_count = std::max<size_t>(socket_count / 100, 1);
+  const uint8_t datagram[16]{};
+
+  size_t next_socket = 0;
+  base::PreciseTime total_time{};
+
+  for (size_t iteration = 0; iteration < iterations; ++iteration) {
+    for (size_t i = 0; i < active_count; ++i) {
+      const auto& socket = sockets[next_socket];
+      next_socket = (next_socket + 1) % sockets.size();
+
+      verify(sender.send_to(socket.local_address(), datagram), "failed to send datagram");
+    }
+
+    const auto expected_datagrams = received_datagrams + active_count;
+
+    base::Stopwatch stopwatch;
+    while (received_datagrams < expected_datagrams) {
+      verify(context.run({.timeout = base::PreciseTime::from_seconds(1.0)}) ==
+               async_net::IoContext::RunResult::Ok,
+             "run failed");
+    }
+    total_time += stopwatch.elapsed();
+  }
+
+  log_info("{:>6} sockets, {:>4} active: {} per iteration", socket_count, active_count,
+           total_time / iterations);
+}
+
+int main() {
+  base::initialize();
+
+  raise_file_limit();
+
+  const size_t iterations = 1000;
+
+  for (const size_t socket_count : {1'000, 10'000, 100'000}) {
+    run_benchmark(socket_count, iterations);
+  }
+}
@@ -0,0 +1,86 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Measures throughput of `IoContext::post_atomic` when multiple threads post work to a single
+// context at the same time and how many times the producers had to wake the context up. Tasks can
+// be made to take some time to keep the context busy while producers post.
+
+static void spin_for(base::PreciseTime duration) {
+  const auto end = base::PreciseTime::now() + duration;
+  while (base::PreciseTime::now() < end) {
+  }
+}
+
+static void benchmark_producers(size_t producer_count,
+                                size_t posts_per_producer,
+                                base::PreciseTime task_duration) {
+  async_net::IoContext context;
+
+  const size_t total_posts = producer_count * posts_per_producer;
+  size_t executed_posts = 0;
+
+  std::atomic_bool start{};
+
+  std::vector<std::thread> producers;
+  producers.reserve(producer_count);
+
+  for (size_t i = 0; i < producer_count; ++i) {
+    producers.emplace_back([&] {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+
+      for (size_t j = 0; j < posts_per_producer; ++j) {
+        context.post_atomic([&] {
+          if (!task_duration.is_zero()) {
+            spin_for(task_duration);
+          }
+          executed_posts++;
+        });
+      }
+    });
+  }
+
+  base::Stopwatch stopwatch;
+  start.store(true, std::memory_order_release);
+
+  while (executed_posts < total_posts) {
+    verify(context.run({}) == async_net::IoContext::RunResult::Ok, "failed to run IO context");
+  }
+
+  const auto elapsed = stopwatch.elapsed();
+  const auto stats = context.stats();
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  log_info("{:>2} producers, {} tasks: {:.0f} posts/s ({} per post), {} iterations, {:.6f} "
+           "wakeups per post",
+           producer_count, task_duration, double(total_posts) / elapsed.seconds(),
+           elapsed / total_posts, stats.iterations, double(stats.wakeups) / double(total_posts));
+}
+
+int main() {
+  base::initialize();
+
+  const size_t total_posts = 1'000'000;
+
+  for (const size_t producer_count : {1, 4, 16}) {
+    benchmark_producers(producer_count, total_posts / producer_count, {});
+  }
+
+  // Busy context: producers post while the context is running callbacks.
+  const auto task_duration = base::PreciseTime::from_microseconds(1);
+  for (const size_t producer_count : {1, 4, 16}) {
+    benchmark_producers(producer_count, total_posts / 10 / producer_count, task_duration);
+  }
+}
@@ -0,0 +1,158 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/SharedBuffer.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Measures a loopback TCP relay (producer -> relay -> consumer) which copies the data through
+// `on_data_received` and `send_data` versus one which splices it with `TcpConnection::relay_to`.
+// CPU time covers the whole process, so the producer and the consumer add the same cost to both.
+// The last mode starts relaying from `on_data_received` after parsing a header which arrives in
+// parts, the consumer checks that no header byte gets forwarded.
+
+constexpr uint16_t relay_port = 44451;
+constexpr uint16_t consumer_port = 44452;
+constexpr size_t chunk_size = 1024 * 1024;
+constexpr size_t chunk_count = 4096;
+// Number of chunks the producer can be ahead of the consumer.
+constexpr size_t send_window = 8;
+constexpr std::string_view header = "HEADER!!";
+constexpr uint8_t payload_byte = 0x5a;
+
+enum class RelayMode {
+  Copy,
+  Splice,
+  SpliceAfterHeader,
+};
+
+static void run_benchmark(std::string_view name, RelayMode mode) {
+  async_net::IoContext context;
+
+  async_net::TcpListener consumer_listener{context, async_net::IpAddress::loopback(),
+                                           consumer_port};
+  std::optional<async_net::TcpConnection> consumer;
+  uint64_t bytes_consumed = 0;
+
+  // Relay: accepts the producer and forwards its data to the consumer.
+  async_net::TcpListener relay_listener{context, async_net::IpAddress::loopback(), relay_port};
+  async_net::TcpConnection relay_output{context, async_net::IpAddress::loopback(), consumer_port};
+  std::optional<async_net::TcpConnection> relay_input;
+
+  relay_output.set_max_send_buffer_size(std::numeric_limits<size_t>::max());
+  relay_output.set_on_connected([](async_net::Status status) {
+    verify(status, "failed to connect to the consumer: {}", status.stringify());
+  });
+
+  relay_listener.set_on_accept([&](async_net::Status status, async_net::TcpConnection connection) {
+    verify(status, "failed to accept the producer: {}", status.stringify());
+
+    relay_input = std::move(connection);
+  });
+
+  // Producer.
+  async_net::TcpConnection producer{context, async_net::IpAddress::loopback(), relay_port};
+  const auto chunk =
+    async_net::SharedBuffer::copy(std::vector<uint8_t>(chunk_size, payload_byte));
+  size_t chunks_produced = 0;
+
+  const auto produce = [&] {
+    while (chunks_produced < chunk_count &&
+           chunks_produced * chunk_size < bytes_consumed + send_window * chunk_size) {
+      producer.send_shared_force(chunk);
+      chunks_produced++;
+    }
+  };
+
+  consumer_listener.set_on_accept([&](async_net::Status status,
+                                      async_net::TcpConnection connection) {
+    verify(status, "failed to accept the relay: {}", status.stringify());
+
+    consumer = std::move(connection);
+    consumer->set_on_data_received([&](std::span<const uint8_t> data) {
+      verify(data[0] == payload_byte && data.back() == payload_byte,
+             "consumer received unexpected data");
+      bytes_consumed += data.size();
+      produce();
+      return data.size();
+    });
+  });
+
+  producer.set_max_send_buffer_size(std::numeric_limits<size_t>::max());
+  producer.set_on_connected([&](async_net::Status status) {
+    verify(status, "failed to connect to the relay: {}", status.stringify());
+  });
+
+  // Both sides of the relay have to be connected before relaying can start.
+  while (!relay_input || !consumer || !relay_output.is_connected()) {
+    verify(context.run({}) == async_net::IoContext::RunResult::Ok, "failed to run IO context");
+  }
+
+  if (mode == RelayMode::Copy) {
+    relay_input->set_on_data_received([&](std::span<const uint8_t> data) {
+      relay_output.send_data_force(data);
+      return data.size();
+    });
+  } else if (mode == RelayMode::Splice) {
+    verify(relay_input->relay_to(relay_output), "failed to start relaying");
+  }
+
+  base::Stopwatch stopwatch;
+  const auto cpu_time_before = std::clock();
+
+  if (mode == RelayMode::SpliceAfterHeader) {
+    const auto header_bytes =
+      std::span{reinterpret_cast<const uint8_t*>(header.data()), header.size()};
+    bool received_partial_header = false;
+
+    relay_input->set_on_data_received([&](std::span<const uint8_t> data) -> size_t {
+      if (data.size() < header.size()) {
+        received_partial_header = true;
+        return 0;
+      }
+
+      verify(std::equal(header_bytes.begin(), header_bytes.end(), data.begin()),
+             "relay received invalid header");
+      verify(relay_input->relay_to(relay_output), "failed to start relaying");
+      return header.size();
+    });
+
+    // Send the first half of the header separately and the rest together with the payload.
+    producer.send_data_force(header_bytes.first(header.size() / 2));
+    while (!received_partial_header) {
+      verify(context.run({}) == async_net::IoContext::RunResult::Ok, "failed to run IO context");
+    }
+    producer.send_data_force(header_bytes.subspan(header.size() / 2));
+  }
+
+  produce();
+  while (bytes_consumed < chunk_count * chunk_size) {
+    verify(context.run({}) == async_net::IoContext::RunResult::Ok, "failed to run IO context");
+  }
+  verify(bytes_consumed == chunk_count * chunk_size, "consumer received too much data");
+
+  const auto elapsed = stopwatch.elapsed();
+  const auto cpu_seconds = double(std::clock() - cpu_time_before) / CLOCKS_PER_SEC;
+
+  const auto gigabytes = double(bytes_consumed) / 1'000'000'000.0;
+  log_info("{}: {} ({:.2f} GB/s, {:.3f} CPU seconds per GB)", name, elapsed,
+           gigabytes / elapsed.seconds(), cpu_seconds / gigabytes);
+}
+
+int main() {
+  base::initialize();
+
+  run_benchmark("copy", RelayMode::Copy);
+  run_benchmark("splice", RelayMode::Splice);
+  run_benchmark("splice after header", RelayMode::SpliceAfterHeader);
+}
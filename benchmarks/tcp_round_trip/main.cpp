@@ -0,0 +1,81 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <memory>
+#include <vector>
+
+// Measures request/response round-trip time between an echo server and a client running on the
+// same IoContext.
+
+static void run_benchmark(bool eager_send, size_t round_trips) {
+  constexpr uint16_t port = 44445;
+  constexpr size_t message_size = 64;
+
+  async_net::IoContext context;
+
+  async_net::TcpListener listener{context, async_net::IpAddress::loopback(), port};
+  std::unique_ptr<async_net::TcpConnection> server_connection;
+
+  listener.set_on_accept([&](async_net::Status status, async_net::TcpConnection connection) {
+    verify(status, "failed to accept connection: {}", status.stringify());
+
+    server_connection = std::make_unique<async_net::TcpConnection>(std::move(connection));
+    server_connection->set_eager_send(eager_send);
+    server_connection->set_on_data_received([&](std::span<const uint8_t> data) {
+      verify(server_connection->send_data(data), "failed to send data");
+      return data.size();
+    });
+  });
+
+  async_net::TcpConnection client{context, async_net::IpAddress::loopback(), port};
+  client.set_eager_send(eager_send);
+
+  const std::vector<uint8_t> message(message_size);
+
+  size_t completed_round_trips = 0;
+  base::Stopwatch stopwatch;
+
+  client.set_on_connected([&](async_net::Status status) {
+    verify(status, "failed to connect: {}", status.stringify());
+
+    stopwatch.reset();
+    verify(client.send_data(message), "failed to send data");
+  });
+
+  client.set_on_data_received([&](std::span<const uint8_t> data) {
+    if (data.size() < message_size) {
+      return size_t(0);
+    }
+
+    if (++completed_round_trips == round_trips) {
+      const auto elapsed = stopwatch.elapsed();
+
+      log_info("eager send {:>5}: {} per round trip", eager_send, elapsed / round_trips);
+
+      client.shutdown();
+      server_connection = nullptr;
+      listener.shutdown();
+    } else {
+      verify(client.send_data(message), "failed to send data");
+    }
+
+    return message_size;
+  });
+
+  verify(context.run_until_no_work(), "run failed");
+}
+
+int main() {
+  base::initialize();
+
+  const size_t round_trips = 100'000;
+
+  run_benchmark(false, round_trips);
+  run_benchmark(true, round_trips);
+}
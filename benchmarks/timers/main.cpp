@@ -0,0 +1,106 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/rng/PseudoRng.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/Timer.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+// Measures timer insert, cancel and fire throughput and how late short timers fire.
+
+static void log_result(std::string_view operation, size_t count, base::PreciseTime elapsed) {
+  log_info("{:<7} {} timers: {} ({} per timer)", operation, count, elapsed, elapsed / count);
+}
+
+static void benchmark_insert_and_cancel(size_t timer_count) {
+  async_net::IoContext context;
+  base::PseudoRng rng{1};
+
+  std::vector<async_net::Timer> timers;
+  timers.reserve(timer_count);
+
+  base::Stopwatch stopwatch;
+
+  // Spread timeouts between 1 second and 1 hour to exercise all wheel levels.
+  for (size_t i = 0; i < timer_count; ++i) {
+    const auto timeout = base::PreciseTime::from_milliseconds(1'000 + rng.gen() % 3'600'000);
+    timers.push_back(async_net::Timer::invoke_after(context, timeout, [] {}));
+  }
+
+  log_result("insert", timer_count, stopwatch.reset());
+
+  for (auto& timer : timers) {
+    timer.reset();
+  }
+
+  log_result("cancel", timer_count, stopwatch.reset());
+}
+
+static void benchmark_fire(size_t timer_count) {
+  async_net::IoContext context;
+  base::PseudoRng rng{2};
+
+  size_t fired_timers = 0;
+
+  // Deadlines are spread over 100 ms and most of them have passed by the time the context runs, so
+  // this mostly measures expiring a large batch of timers at once.
+  const auto now = base::PreciseTime::now();
+  for (size_t i = 0; i < timer_count; ++i) {
+    const auto deadline = now + base::PreciseTime::from_microseconds(rng.gen() % 100'000);
+    async_net::Timer::invoke_at_deadline_detached(context, deadline, [&] { fired_timers++; });
+  }
+
+  base::Stopwatch stopwatch;
+
+  verify(context.run_until_no_work(), "run failed");
+  verify(fired_timers == timer_count, "not all timers have fired");
+
+  log_result("fire", timer_count, stopwatch.reset());
+}
+
+static void benchmark_lateness(bool precise_timers, size_t timer_count) {
+  async_net::IoContext context{{.precise_timers = precise_timers}};
+
+  const auto timeout = base::PreciseTime::from_microseconds(200);
+
+  size_t fired_timers = 0;
+  base::PreciseTime total_lateness{};
+  base::PreciseTime max_lateness{};
+
+  // Timers are chained so that only one of them is pending at any time.
+  std::move_only_function<void()> schedule_timer = [&] {
+    const auto deadline = base::PreciseTime::now() + timeout;
+    async_net::Timer::invoke_at_deadline_detached(context, deadline, [&, deadline] {
+      const auto lateness = base::PreciseTime::now() - deadline;
+      total_lateness += lateness;
+      max_lateness = std::max(max_lateness, lateness);
+
+      if (++fired_timers < timer_count) {
+        schedule_timer();
+      }
+    });
+  };
+  schedule_timer();
+
+  verify(context.run_until_no_work(), "run failed");
+
+  log_info("precise timers {:>5}: {} timeout, {} mean lateness, {} max lateness", precise_timers,
+           timeout, total_lateness / timer_count, max_lateness);
+}
+
+int main() {
+  base::initialize();
+
+  const size_t timer_count = 1'000'000;
+
+  benchmark_insert_and_cancel(timer_count);
+  benchmark_fire(timer_count);
+
+  benchmark_lateness(false, 2'000);
+  benchmark_lateness(true, 2'000);
+}
@@ -0,0 +1,116 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/UdpSocket.hpp>
+
+#include <ctime>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+// Measures a loopback UDP stream of media-sized datagrams sent as separate datagrams, with UDP
+// segmentation offload (GSO) and with GSO plus receive coalescing (GRO) on the receiver. Datagrams
+// dropped by the kernel are counted once the receiver stops making progress.
+
+constexpr uint16_t receiver_port = 44453;
+constexpr uint16_t sender_port = 44454;
+constexpr size_t segment_size = 1200;
+constexpr size_t chunk_size = 64 * segment_size;
+constexpr size_t chunk_count = 8192;
+// Number of bytes the sender can be ahead of the receiver. More than that overflows the default
+// socket receive buffer, making the kernel drop datagrams.
+constexpr size_t send_window = chunk_size;
+
+struct BenchmarkMode {
+  bool segmentation_offload{};
+  bool receive_coalescing{};
+};
+
+static void run_benchmark(std::string_view name, BenchmarkMode mode) {
+  async_net::IoContext context;
+
+  async_net::UdpSocket receiver{context, async_net::IpAddress::loopback(), receiver_port,
+                                {.receive_coalescing = mode.receive_coalescing}};
+  async_net::UdpSocket sender{context, async_net::IpAddress::loopback(), sender_port,
+                              {.segmentation_offload = mode.segmentation_offload}};
+
+  uint64_t bytes_received = 0;
+  uint64_t datagrams_received = 0;
+  uint64_t batches_received = 0;
+
+  receiver.set_on_batch_received(
+    [&](std::span<const async_net::UdpSocket::ReceivedDatagram> datagrams) {
+      for (const auto& datagram : datagrams) {
+        verify(datagram.data.size() == segment_size, "received datagram has unexpected size");
+        bytes_received += datagram.data.size();
+      }
+      datagrams_received += datagrams.size();
+      batches_received++;
+    });
+
+  sender.set_max_send_buffer_size(std::numeric_limits<size_t>::max());
+  sender.set_flush_immediately(true);
+  sender.set_on_send_error([](async_net::Status status) {
+    verify(false, "failed to send datagrams: {}", status.stringify());
+  });
+
+  const std::vector<uint8_t> chunk(chunk_size, 0x5a);
+  const async_net::SocketAddress destination{async_net::IpAddress::loopback(), receiver_port};
+
+  size_t chunks_sent = 0;
+  uint64_t bytes_lost = 0;
+
+  base::Stopwatch stopwatch;
+  const auto cpu_time_before = std::clock();
+
+  auto last_progress = base::PreciseTime::now();
+  uint64_t last_bytes_received = 0;
+
+  while (true) {
+    const uint64_t bytes_sent = chunks_sent * chunk_size;
+    if (chunks_sent < chunk_count && bytes_sent - bytes_received - bytes_lost < send_window) {
+      verify(sender.send_segmented_data(destination, chunk, segment_size),
+             "failed to queue datagrams");
+      chunks_sent++;
+    }
+
+    verify(context.run({.timeout = base::PreciseTime::from_milliseconds(1)}) ==
+             async_net::IoContext::RunResult::Ok,
+           "failed to run IO context");
+
+    const auto now = base::PreciseTime::now();
+    if (bytes_received != last_bytes_received) {
+      last_bytes_received = bytes_received;
+      last_progress = now;
+    } else if (now - last_progress > base::PreciseTime::from_milliseconds(20)) {
+      // Everything still in flight has been dropped.
+      bytes_lost = chunks_sent * chunk_size - bytes_received;
+      last_progress = now;
+
+      if (chunks_sent == chunk_count) {
+        break;
+      }
+    }
+  }
+
+  const auto cpu_seconds = double(std::clock() - cpu_time_before) / CLOCKS_PER_SEC;
+  const auto elapsed = stopwatch.elapsed();
+  const auto gigabytes = double(bytes_received) / 1'000'000'000.0;
+
+  log_info("{}: {} ({:.2f} GB/s, {:.3f} CPU seconds per GB)", name, elapsed,
+           gigabytes / elapsed.seconds(), cpu_seconds / gigabytes);
+  log_info("{}: {} datagrams received in {} batches, {:.2f}% lost", name, datagrams_received,
+           batches_received, 100.0 * double(bytes_lost) / double(chunk_count * chunk_size));
+}
+
+int main() {
+  base::initialize();
+
+  run_benchmark("separate datagrams", {});
+  run_benchmark("segmentation offload", {.segmentation_offload = true});
+  run_benchmark("segmentation offload + receive coalescing",
+                {.segmentation_offload = true, .receive_coalescing = true});
+}
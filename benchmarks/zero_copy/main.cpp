@@ -0,0 +1,96 @@
+#include <base/Initialization.hpp>
+#include <base/Log.hpp>
+#include <base/Panic.hpp>
+#include <base/time/Stopwatch.hpp>
+
+#include <async_net/IoContext.hpp>
+#include <async_net/SharedBuffer.hpp>
+#include <async_net/TcpConnection.hpp>
+#include <async_net/TcpListener.hpp>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Measures loopback throughput of large payloads copied to the send buffer, queued as shared
+// buffers and sent with MSG_ZEROCOPY. The kernel copies zero-copy data looped to a local socket
+// anyway, in which case the connection falls back to regular sends (reported below).
+
+constexpr uint16_t port = 44450;
+constexpr size_t chunk_size = 4 * 1024 * 1024;
+constexpr size_t chunk_count = 512;
+// Number of chunks queued ahead of what has been sent.
+constexpr size_t send_window = 4;
+constexpr size_t zero_copy_threshold = 64 * 1024;
+
+enum class SendMode {
+  Copy,
+  Shared,
+  ZeroCopy,
+};
+
+static void run_benchmark(std::string_view name, SendMode mode) {
+  async_net::IoContext context;
+
+  async_net::TcpListener listener{context, async_net::IpAddress::loopback(), port};
+  std::optional<async_net::TcpConnection> sender;
+
+  const std::vector<uint8_t> chunk(chunk_size, 0x5a);
+  const auto shared_chunk = async_net::SharedBuffer::copy(chunk);
+
+  size_t chunks_queued = 0;
+  uint64_t bytes_received = 0;
+
+  const auto queue_chunks = [&] {
+    while (chunks_queued < chunk_count && sender->pending_to_send() < send_window * chunk_size) {
+      if (mode == SendMode::Copy) {
+        sender->send_data_force(chunk);
+      } else {
+        sender->send_shared_force(shared_chunk);
+      }
+      chunks_queued++;
+    }
+  };
+
+  listener.set_on_accept([&](async_net::Status status, async_net::TcpConnection connection) {
+    verify(status, "failed to accept connection: {}", status.stringify());
+
+    sender = std::move(connection);
+    sender->set_max_send_buffer_size(send_window * chunk_size);
+    if (mode == SendMode::ZeroCopy) {
+      sender->set_zero_copy_threshold(zero_copy_threshold);
+    }
+    sender->set_on_data_sent([&] { queue_chunks(); });
+
+    queue_chunks();
+  });
+
+  async_net::TcpConnection receiver{context, async_net::IpAddress::loopback(), port};
+  receiver.set_on_connected([](async_net::Status status) {
+    verify(status, "failed to connect: {}", status.stringify());
+  });
+  receiver.set_on_data_received([&](std::span<const uint8_t> data) {
+    bytes_received += data.size();
+    return data.size();
+  });
+
+  base::Stopwatch stopwatch;
+  while (bytes_received < chunk_count * chunk_size) {
+    verify(context.run({}) == async_net::IoContext::RunResult::Ok, "failed to run IO context");
+  }
+  const auto elapsed = stopwatch.elapsed();
+
+  log_info("{}: {} ({:.0f} MB/s)", name, elapsed,
+           double(bytes_received) / elapsed.seconds() / 1'000'000.0);
+  if (mode == SendMode::ZeroCopy && sender->zero_copy_threshold() == 0) {
+    log_info("{}: kernel copied the data, fell back to regular sends", name);
+  }
+}
+
+int main() {
+  base::initialize();
+
+  run_benchmark("copy", SendMode::Copy);
+  run_benchmark("shared buffer", SendMode::Shared);
+  run_benchmark("zero-copy", SendMode::ZeroCopy);
+}
@@ -39,6 +39,28 @@
 #include <unistd.h>
 #endif
 
+#if defined(SOCKLIB_LINUX)
+#include <linux/errqueue.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/udp.h>
+#include <sys/sendfile.h>
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define SOCKLIB_ZERO_COPY
+#endif
+
+#if defined(UDP_SEGMENT) && defined(UDP_GRO)
+#define SOCKLIB_UDP_OFFLOAD
+#endif
+
+// epoll_pwait2 (timeout with nanosecond precision) is exposed by glibc 2.35 and newer.
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 35)
+#define SOCKLIB_EPOLL_PWAIT2
+#endif
+
+#endif
+
 #ifndef MSG_NOSIGNAL
 #define MSG_NOSIGNAL 0
 #endif
@@ -943,6 +965,22 @@ sock::Status sock::DatagramSocket::set_broadcast_enabled(bool broadcast_enabled)
   return set_socket_option<int>(raw_socket_, SOL_SOCKET, SO_BROADCAST, broadcast_enabled ? 1 : 0);
 }
 
+bool sock::DatagramSocket::is_segmentation_offload_supported() {
+#if defined(SOCKLIB_UDP_OFFLOAD)
+  return true;
+#else
+  return false;
+#endif
+}
+
+sock::Status sock::DatagramSocket::set_receive_coalescing(bool coalescing_enabled) {
+#if defined(SOCKLIB_UDP_OFFLOAD)
+  return set_socket_option<int>(raw_socket_, IPPROTO_UDP, UDP_GRO, coalescing_enabled ? 1 : 0);
+#else
+  return Status{Error::SetSocketOptionFailed, Error::Unsupported};
+#endif
+}
+
 sock::Result<size_t> sock::DatagramSocket::send_to(const SocketAddress& to,
                                                    const void* data,
                                                    size_t data_size) {
@@ -963,6 +1001,228 @@ sock::Result<size_t> sock::DatagramSocket::receive(void* data, size_t data_size)
   return receive_from_internal(nullptr, data, data_size);
 }
 
+sock::Result<size_t> sock::DatagramSocket::receive_many(std::span<ReceiveSlot> slots) {
+  slots = slots.subspan(0, std::min(slots.size(), max_receive_slots));
+  if (slots.empty()) {
+    return {};
+  }
+
+#if defined(SOCKLIB_LINUX)
+  mmsghdr messages[max_receive_slots]{};
+  iovec buffers[max_receive_slots];
+  SockaddrBuffer socket_addresses[max_receive_slots];
+#if defined(SOCKLIB_UDP_OFFLOAD)
+  struct alignas(cmsghdr) ControlBuffer {
+    uint8_t data[CMSG_SPACE(sizeof(int))];
+  };
+  ControlBuffer control_buffers[max_receive_slots];
+#endif
+
+  for (size_t i = 0; i < slots.size(); ++i) {
+    if (slots[i].data.size() > size_t(std::numeric_limits<int>::max())) {
+      return {
+        .status = {Error::ReceiveFailed, Error::SizeTooLarge},
+      };
+    }
+
+    buffers[i] = {
+      .iov_base = slots[i].data.data(),
+      .iov_len = slots[i].data.size(),
+    };
+
+    auto& header = messages[i].msg_hdr;
+    header.msg_iov = &buffers[i];
+    header.msg_iovlen = 1;
+    if (slots[i].from) {
+      header.msg_name = socket_addresses[i].data;
+      header.msg_namelen = sizeof(socket_addresses[i]);
+    }
+#if defined(SOCKLIB_UDP_OFFLOAD)
+    header.msg_control = control_buffers[i].data;
+    header.msg_controllen = sizeof(control_buffers[i].data);
+#endif
+  }
+
+  const auto result = handle_eintr(
+    [&] { return ::recvmmsg(raw_socket_, messages, unsigned(slots.size()), 0, nullptr); });
+  if (is_error(result)) {
+    return {
+      .status = last_error_to_status(Error::ReceiveFailed),
+    };
+  }
+
+  const auto received_count = size_t(result);
+  for (size_t i = 0; i < received_count; ++i) {
+    slots[i].size = messages[i].msg_len;
+    slots[i].segment_size = 0;
+
+#if defined(SOCKLIB_UDP_OFFLOAD)
+    auto& header = messages[i].msg_hdr;
+    for (auto control = CMSG_FIRSTHDR(&header); control; control = CMSG_NXTHDR(&header, control)) {
+      if (control->cmsg_level == IPPROTO_UDP && control->cmsg_type == UDP_GRO) {
+        int segment_size{};
+        std::memcpy(&segment_size, CMSG_DATA(control), sizeof(segment_size));
+        slots[i].segment_size = size_t(segment_size);
+      }
+    }
+#endif
+
+    if (slots[i].from && !socket_address_convert_from_raw(socket_addresses[i],
+                                                          messages[i].msg_hdr.msg_namelen,
+                                                          *slots[i].from)) {
+      return {
+        .status = {Error::ReceiveFailed, Error::AddressConversionFailed},
+      };
+    }
+  }
+
+  return {
+    .status = {},
+    .value = received_count,
+  };
+#else
+  size_t received_count = 0;
+
+  for (auto& slot : slots) {
+    const auto [status, size] =
+      receive_from_internal(slot.from, slot.data.data(), slot.data.size());
+    if (!status) {
+      // Errors (including WouldBlock) are reported by the next call if something was received.
+      if (received_count == 0) {
+        return {
+          .status = status,
+        };
+      }
+      break;
+    }
+
+    slot.size = size;
+    slot.segment_size = 0;
+    received_count++;
+  }
+
+  return {
+    .status = {},
+    .value = received_count,
+  };
+#endif
+}
+
+sock::Result<size_t> sock::DatagramSocket::send_many(std::span<SendSlot> slots) {
+  slots = slots.subspan(0, std::min(slots.size(), max_send_slots));
+  if (slots.empty()) {
+    return {};
+  }
+
+#if defined(SOCKLIB_LINUX)
+  mmsghdr messages[max_send_slots]{};
+  iovec buffers[max_send_slots];
+  SockaddrBuffer socket_addresses[max_send_slots];
+#if defined(SOCKLIB_UDP_OFFLOAD)
+  struct alignas(cmsghdr) ControlBuffer {
+    uint8_t data[CMSG_SPACE(sizeof(uint16_t))];
+  };
+  ControlBuffer control_buffers[max_send_slots];
+#endif
+
+  for (size_t i = 0; i < slots.size(); ++i) {
+    if (slots[i].data.size() > size_t(std::numeric_limits<int>::max()) ||
+        slots[i].segment_size > std::numeric_limits<uint16_t>::max()) {
+      return {
+        .status = {Error::SendFailed, Error::SizeTooLarge},
+      };
+    }
+
+    buffers[i] = {
+      .iov_base = const_cast<uint8_t*>(slots[i].data.data()),
+      .iov_len = slots[i].data.size(),
+    };
+
+    auto& header = messages[i].msg_hdr;
+    header.msg_iov = &buffers[i];
+    header.msg_iovlen = 1;
+    if (slots[i].to) {
+      socket_address_convert_to_raw(
+        *slots[i].to, [&](const sockaddr* socket_address, socklen_t sockaddr_size) {
+          std::memcpy(socket_addresses[i].data, socket_address, sockaddr_size);
+          header.msg_name = socket_addresses[i].data;
+          header.msg_namelen = sockaddr_size;
+        });
+    }
+
+    if (slots[i].segment_size > 0) {
+#if defined(SOCKLIB_UDP_OFFLOAD)
+      header.msg_control = control_buffers[i].data;
+      header.msg_controllen = sizeof(control_buffers[i].data);
+
+      const auto control = CMSG_FIRSTHDR(&header);
+      control->cmsg_level = IPPROTO_UDP;
+      control->cmsg_type = UDP_SEGMENT;
+      control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+
+      const auto segment_size = uint16_t(slots[i].segment_size);
+      std::memcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+#else
+      return {
+        .status = {Error::SendFailed, Error::Unsupported},
+      };
+#endif
+    }
+  }
+
+  const auto result = handle_eintr(
+    [&] { return ::sendmmsg(raw_socket_, messages, unsigned(slots.size()), MSG_NOSIGNAL); });
+  if (is_error(result)) {
+    return {
+      .status = last_error_to_status(Error::SendFailed),
+    };
+  }
+
+  const auto sent_count = size_t(result);
+  for (size_t i = 0; i < sent_count; ++i) {
+    slots[i].size = messages[i].msg_len;
+  }
+
+  return {
+    .status = {},
+    .value = sent_count,
+  };
+#else
+  size_t sent_count = 0;
+
+  for (auto& slot : slots) {
+    // Segmentation offload is only supported on Linux.
+    if (slot.segment_size > 0) {
+      if (sent_count == 0) {
+        return {
+          .status = {Error::SendFailed, Error::Unsupported},
+        };
+      }
+      break;
+    }
+
+    const auto [status, size] = send_to_internal(slot.to, slot.data.data(), slot.data.size());
+    if (!status) {
+      // Errors (including WouldBlock) are reported by the next call if something was sent.
+      if (sent_count == 0) {
+        return {
+          .status = status,
+        };
+      }
+      break;
+    }
+
+    slot.size = size;
+    sent_count++;
+  }
+
+  return {
+    .status = {},
+    .value = sent_count,
+  };
+#endif
+}
+
 sock::Result<sock::StreamSocket> sock::StreamSocket::connect(
   const SocketAddress& address,
   const ConnectParameters& connect_parameters) {
@@ -1138,19 +1398,28 @@ sock::Status sock::StreamSocket::set_no_delay(bool no_delay_enabled) {
   return set_socket_option<int>(raw_socket_, IPPROTO_TCP, TCP_NODELAY, no_delay_enabled ? 1 : 0);
 }
 
-sock::Result<size_t> sock::StreamSocket::send(const void* data, size_t data_size) {
-  if (data_size == 0) {
+sock::Status sock::StreamSocket::set_zero_copy(bool zero_copy_enabled) {
+#if defined(SOCKLIB_ZERO_COPY)
+  return set_socket_option<int>(raw_socket_, SOL_SOCKET, SO_ZEROCOPY, zero_copy_enabled ? 1 : 0);
+#else
+  return Status{Error::SetSocketOptionFailed, Error::Unsupported};
+#endif
+}
+
+sock::Result<size_t> sock::StreamSocket::send_zero_copy(std::span<const uint8_t> data) {
+#if defined(SOCKLIB_ZERO_COPY)
+  if (data.empty()) {
     return {};
   }
 
-  if (data_size > std::numeric_limits<int>::max()) {
+  if (data.size() > std::numeric_limits<int>::max()) {
     return {
       .status = {Error::SendFailed, Error::SizeTooLarge},
     };
   }
 
   const auto result = handle_eintr([&] {
-    return ::send(raw_socket_, reinterpret_cast<const char*>(data), data_size, MSG_NOSIGNAL);
+    return ::send(raw_socket_, data.data(), data.size(), MSG_NOSIGNAL | MSG_ZEROCOPY);
   });
   if (result == 0) {
     return {
@@ -1167,43 +1436,88 @@ sock::Result<size_t> sock::StreamSocket::send(const void* data, size_t data_size
     .status = {},
     .value = size_t(result),
   };
+#else
+  return {
+    .status = {Error::SendFailed, Error::Unsupported},
+  };
+#endif
 }
 
-sock::Result<size_t> sock::StreamSocket::send_all(const void* data, size_t data_size) {
-  auto current = reinterpret_cast<const uint8_t*>(data);
-  size_t bytes_sent = 0;
+sock::Result<sock::KernelPipe> sock::KernelPipe::create(size_t capacity) {
+#if defined(SOCKLIB_LINUX)
+  int pipe_ends[2]{};
+  if (::pipe2(pipe_ends, O_NONBLOCK | O_CLOEXEC) != 0) {
+    return {
+      .status = last_error_to_status(Error::SocketCreationFailed),
+    };
+  }
 
-  while (bytes_sent < data_size) {
-    const auto [status, current_sent] = send(current, data_size - bytes_sent);
-    if (!status) {
-      return {
-        .status = status,
-        .value = bytes_sent,
-      };
-    }
-    current += current_sent;
-    bytes_sent += current_sent;
+  // Failing to resize the pipe isn't fatal, it will just move less data at once.
+  const auto requested_capacity = int(std::min(capacity, size_t(std::numeric_limits<int>::max())));
+  (void)::fcntl(pipe_ends[1], F_SETPIPE_SZ, requested_capacity);
+
+  const auto actual_capacity = ::fcntl(pipe_ends[1], F_GETPIPE_SZ);
+  if (actual_capacity <= 0) {
+    const auto status = last_error_to_status(Error::SocketSetupFailed);
+    ::close(pipe_ends[0]);
+    ::close(pipe_ends[1]);
+    return {
+      .status = status,
+    };
   }
 
   return {
     .status = {},
-    .value = bytes_sent,
+    .value = KernelPipe{pipe_ends[0], pipe_ends[1], size_t(actual_capacity)},
   };
+#else
+  return {
+    .status = {Error::SocketCreationFailed, Error::Unsupported},
+  };
+#endif
 }
 
-sock::Result<size_t> sock::StreamSocket::receive(void* data, size_t data_size) {
-  if (data_size == 0) {
-    return {};
+sock::KernelPipe::KernelPipe(KernelPipe&& other) noexcept {
+  *this = std::move(other);
+}
+
+sock::KernelPipe& sock::KernelPipe::operator=(KernelPipe&& other) noexcept {
+  if (this != &other) {
+    close();
+
+    read_end_ = std::exchange(other.read_end_, -1);
+    write_end_ = std::exchange(other.write_end_, -1);
+    capacity_ = std::exchange(other.capacity_, 0);
   }
+  return *this;
+}
 
-  if (data_size > std::numeric_limits<int>::max()) {
-    return {
-      .status = {Error::ReceiveFailed, Error::SizeTooLarge},
-    };
+sock::KernelPipe::~KernelPipe() {
+  close();
+}
+
+void sock::KernelPipe::close() {
+#if defined(SOCKLIB_LINUX)
+  if (read_end_ >= 0) {
+    ::close(read_end_);
+    ::close(write_end_);
   }
+#endif
+  read_end_ = -1;
+  write_end_ = -1;
+  capacity_ = 0;
+}
 
-  const auto result =
-    handle_eintr([&] { return ::recv(raw_socket_, reinterpret_cast<char*>(data), data_size, 0); });
+sock::Result<size_t> sock::StreamSocket::receive_to_pipe(KernelPipe& pipe, size_t size) {
+#if defined(SOCKLIB_LINUX)
+  if (size == 0) {
+    return {};
+  }
+
+  const auto result = handle_eintr([&] {
+    return ::splice(raw_socket_, nullptr, pipe.write_end_, nullptr, size,
+                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  });
   if (result == 0) {
     return {
       .status = Status{Error::ReceiveFailed, Error::None, SystemError::Disconnected},
@@ -1219,63 +1533,362 @@ sock::Result<size_t> sock::StreamSocket::receive(void* data, size_t data_size) {
     .status = {},
     .value = size_t(result),
   };
+#else
+  return {
+    .status = {Error::ReceiveFailed, Error::Unsupported},
+  };
+#endif
 }
 
-sock::Result<size_t> sock::StreamSocket::receive_exact(void* data, size_t data_size) {
-  auto current = reinterpret_cast<uint8_t*>(data);
-  size_t bytes_received = 0;
+sock::Result<size_t> sock::StreamSocket::send_from_pipe(KernelPipe& pipe, size_t size) {
+#if defined(SOCKLIB_LINUX)
+  if (size == 0) {
+    return {};
+  }
 
-  while (bytes_received < data_size) {
-    const auto [status, current_received] = receive(current, data_size - bytes_received);
-    if (!status) {
-      return {
-        .status = status,
-        .value = bytes_received,
-      };
-    }
-    current += current_received;
-    bytes_received += current_received;
+  const auto result = handle_eintr([&] {
+    return ::splice(pipe.read_end_, nullptr, raw_socket_, nullptr, size,
+                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  });
+  if (is_error_ext(result)) {
+    return {
+      .status = last_error_to_status(Error::SendFailed),
+    };
   }
 
   return {
     .status = {},
-    .value = bytes_received,
+    .value = size_t(result),
+  };
+#else
+  return {
+    .status = {Error::SendFailed, Error::Unsupported},
   };
+#endif
 }
 
-sock::ConnectingStreamSocket::ConnectingStreamSocket(detail::RawSocket raw_socket,
-                                                     std::unique_ptr<uint64_t[]> socket_address,
-                                                     size_t socket_address_size)
-    : Socket(raw_socket),
-      socket_address(std::move(socket_address)),
-      socket_address_size(socket_address_size) {}
-
-sock::ConnectingStreamSocket::ConnectingStreamSocket(ConnectingStreamSocket&& other) noexcept {
-  raw_socket_ = other.raw_socket_;
-  socket_address = std::move(other.socket_address);
-  socket_address_size = other.socket_address_size;
-
-  other.raw_socket_ = detail::invalid_raw_socket;
-  other.socket_address = {};
-  other.socket_address_size = 0;
+bool sock::StreamSocket::is_send_file_supported() {
+#if defined(SOCKLIB_LINUX)
+  return true;
+#else
+  return false;
+#endif
 }
 
-sock::ConnectingStreamSocket& sock::ConnectingStreamSocket::operator=(
-  sock::ConnectingStreamSocket&& other) noexcept {
-  if (this != &other) {
-    close_socket_if_valid(raw_socket_);
-
-    raw_socket_ = other.raw_socket_;
-    socket_address = std::move(other.socket_address);
-    socket_address_size = other.socket_address_size;
-
-    other.raw_socket_ = detail::invalid_raw_socket;
-    other.socket_address = {};
-    other.socket_address_size = 0;
+sock::Result<size_t> sock::StreamSocket::send_file(int file_descriptor,
+                                                   uint64_t offset,
+                                                   size_t size) {
+#if defined(SOCKLIB_LINUX)
+  if (size == 0) {
+    return {};
   }
 
-  return *this;
-}
+  if (offset > uint64_t(std::numeric_limits<off_t>::max())) {
+    return {
+      .status = {Error::SendFailed, Error::SizeTooLarge},
+    };
+  }
+
+  auto file_offset = off_t(offset);
+  const auto result =
+    handle_eintr([&] { return ::sendfile(raw_socket_, file_descriptor, &file_offset, size); });
+  if (result == 0) {
+    // The file ended before all requested data was sent.
+    return {
+      .status = Status{Error::SendFailed, Error::None, SystemError::InvalidValue},
+    };
+  }
+  if (is_error_ext(result)) {
+    return {
+      .status = last_error_to_status(Error::SendFailed),
+    };
+  }
+
+  return {
+    .status = {},
+    .value = size_t(result),
+  };
+#else
+  return {
+    .status = {Error::SendFailed, Error::Unsupported},
+  };
+#endif
+}
+
+sock::Result<sock::StreamSocket::ZeroCopyCompletion>
+sock::StreamSocket::receive_zero_copy_completion() {
+#if defined(SOCKLIB_ZERO_COPY)
+  alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+
+  msghdr message{};
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  const auto result =
+    handle_eintr([&] { return ::recvmsg(raw_socket_, &message, MSG_ERRQUEUE | MSG_DONTWAIT); });
+  if (is_error_ext(result)) {
+    return {
+      .status = last_error_to_status(Error::ReceiveFailed),
+    };
+  }
+
+  for (auto header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+    const auto is_extended_error =
+      (header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) ||
+      (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR);
+    if (!is_extended_error) {
+      continue;
+    }
+
+    sock_extended_err error{};
+    std::memcpy(&error, CMSG_DATA(header), sizeof(error));
+
+    if (error.ee_errno == 0 && error.ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+      return {
+        .status = {},
+        .value =
+          {
+            .first_send = error.ee_info,
+            .last_send = error.ee_data,
+            .copied = (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0,
+          },
+      };
+    }
+  }
+
+  return {
+    .status = {Error::ReceiveFailed, Error::None, SystemError::Unknown},
+  };
+#else
+  return {
+    .status = {Error::ReceiveFailed, Error::Unsupported},
+  };
+#endif
+}
+
+sock::Result<size_t> sock::StreamSocket::send(const void* data, size_t data_size) {
+  if (data_size == 0) {
+    return {};
+  }
+
+  if (data_size > std::numeric_limits<int>::max()) {
+    return {
+      .status = {Error::SendFailed, Error::SizeTooLarge},
+    };
+  }
+
+  const auto result = handle_eintr([&] {
+    return ::send(raw_socket_, reinterpret_cast<const char*>(data), data_size, MSG_NOSIGNAL);
+  });
+  if (result == 0) {
+    return {
+      .status = Status{Error::SendFailed, Error::None, SystemError::Disconnected},
+    };
+  }
+  if (is_error_ext(result)) {
+    return {
+      .status = last_error_to_status(Error::SendFailed),
+    };
+  }
+
+  return {
+    .status = {},
+    .value = size_t(result),
+  };
+}
+
+sock::Result<size_t> sock::StreamSocket::send_vectored(
+  std::span<const std::span<const uint8_t>> buffers) {
+#if defined(SOCKLIB_WINDOWS)
+  WSABUF raw_buffers[max_vectored_buffers];
+#else
+  iovec raw_buffers[max_vectored_buffers];
+#endif
+
+  size_t buffer_count = 0;
+  size_t total_size = 0;
+
+  for (const auto buffer : buffers) {
+    if (buffer.empty()) {
+      continue;
+    }
+    if (buffer.size() > size_t(std::numeric_limits<int>::max()) - total_size) {
+      if (buffer_count == 0) {
+        return {
+          .status = {Error::SendFailed, Error::SizeTooLarge},
+        };
+      }
+      break;
+    }
+    if (buffer_count == max_vectored_buffers) {
+      break;
+    }
+
+#if defined(SOCKLIB_WINDOWS)
+    raw_buffers[buffer_count] = {
+      .len = ULONG(buffer.size()),
+      .buf = const_cast<char*>(reinterpret_cast<const char*>(buffer.data())),
+    };
+#else
+    raw_buffers[buffer_count] = {
+      .iov_base = const_cast<uint8_t*>(buffer.data()),
+      .iov_len = buffer.size(),
+    };
+#endif
+
+    buffer_count++;
+    total_size += buffer.size();
+  }
+
+  if (buffer_count == 0) {
+    return {};
+  }
+
+#if defined(SOCKLIB_WINDOWS)
+  DWORD bytes_sent = 0;
+  const auto result = handle_eintr([&] {
+    return ::WSASend(raw_socket_, raw_buffers, DWORD(buffer_count), &bytes_sent, 0, nullptr,
+                     nullptr);
+  });
+  if (is_error(result)) {
+    return {
+      .status = last_error_to_status(Error::SendFailed),
+    };
+  }
+  const auto sent_size = size_t(bytes_sent);
+#else
+  msghdr message{};
+  message.msg_iov = raw_buffers;
+  message.msg_iovlen = buffer_count;
+
+  const auto result = handle_eintr([&] { return ::sendmsg(raw_socket_, &message, MSG_NOSIGNAL); });
+  if (is_error_ext(result)) {
+    return {
+      .status = last_error_to_status(Error::SendFailed),
+    };
+  }
+  const auto sent_size = size_t(result);
+#endif
+
+  if (sent_size == 0) {
+    return {
+      .status = Status{Error::SendFailed, Error::None, SystemError::Disconnected},
+    };
+  }
+
+  return {
+    .status = {},
+    .value = sent_size,
+  };
+}
+
+sock::Result<size_t> sock::StreamSocket::send_all(const void* data, size_t data_size) {
+  auto current = reinterpret_cast<const uint8_t*>(data);
+  size_t bytes_sent = 0;
+
+  while (bytes_sent < data_size) {
+    const auto [status, current_sent] = send(current, data_size - bytes_sent);
+    if (!status) {
+      return {
+        .status = status,
+        .value = bytes_sent,
+      };
+    }
+    current += current_sent;
+    bytes_sent += current_sent;
+  }
+
+  return {
+    .status = {},
+    .value = bytes_sent,
+  };
+}
+
+sock::Result<size_t> sock::StreamSocket::receive(void* data, size_t data_size) {
+  if (data_size == 0) {
+    return {};
+  }
+
+  if (data_size > std::numeric_limits<int>::max()) {
+    return {
+      .status = {Error::ReceiveFailed, Error::SizeTooLarge},
+    };
+  }
+
+  const auto result =
+    handle_eintr([&] { return ::recv(raw_socket_, reinterpret_cast<char*>(data), data_size, 0); });
+  if (result == 0) {
+    return {
+      .status = Status{Error::ReceiveFailed, Error::None, SystemError::Disconnected},
+    };
+  }
+  if (is_error_ext(result)) {
+    return {
+      .status = last_error_to_status(Error::ReceiveFailed),
+    };
+  }
+
+  return {
+    .status = {},
+    .value = size_t(result),
+  };
+}
+
+sock::Result<size_t> sock::StreamSocket::receive_exact(void* data, size_t data_size) {
+  auto current = reinterpret_cast<uint8_t*>(data);
+  size_t bytes_received = 0;
+
+  while (bytes_received < data_size) {
+    const auto [status, current_received] = receive(current, data_size - bytes_received);
+    if (!status) {
+      return {
+        .status = status,
+        .value = bytes_received,
+      };
+    }
+    current += current_received;
+    bytes_received += current_received;
+  }
+
+  return {
+    .status = {},
+    .value = bytes_received,
+  };
+}
+
+sock::ConnectingStreamSocket::ConnectingStreamSocket(detail::RawSocket raw_socket,
+                                                     std::unique_ptr<uint64_t[]> socket_address,
+                                                     size_t socket_address_size)
+    : Socket(raw_socket),
+      socket_address(std::move(socket_address)),
+      socket_address_size(socket_address_size) {}
+
+sock::ConnectingStreamSocket::ConnectingStreamSocket(ConnectingStreamSocket&& other) noexcept {
+  raw_socket_ = other.raw_socket_;
+  socket_address = std::move(other.socket_address);
+  socket_address_size = other.socket_address_size;
+
+  other.raw_socket_ = detail::invalid_raw_socket;
+  other.socket_address = {};
+  other.socket_address_size = 0;
+}
+
+sock::ConnectingStreamSocket& sock::ConnectingStreamSocket::operator=(
+  sock::ConnectingStreamSocket&& other) noexcept {
+  if (this != &other) {
+    close_socket_if_valid(raw_socket_);
+
+    raw_socket_ = other.raw_socket_;
+    socket_address = std::move(other.socket_address);
+    socket_address_size = other.socket_address_size;
+
+    other.raw_socket_ = detail::invalid_raw_socket;
+    other.socket_address = {};
+    other.socket_address_size = 0;
+  }
+
+  return *this;
+}
 
 sock::Result<sock::ConnectingStreamSocket::SocketPair>
 sock::ConnectingStreamSocket::initiate_connection(const SocketAddress& address,
@@ -1526,6 +2139,41 @@ class PollCanceller {
   }
 };
 
+#elif defined(SOCKLIB_LINUX)
+
+// A single eventfd works with every poller backend: it becomes readable when the counter is
+// non-zero and one read resets the counter no matter how many times it was signaled.
+class PollCanceller {
+  int event_fd{-1};
+
+ public:
+  PollCanceller() { event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); }
+
+  ~PollCanceller() {
+    if (event_fd != -1) {
+      ::close(event_fd);
+    }
+  }
+
+  bool valid() const { return event_fd != -1; }
+
+  sock::detail::RawSocket cancel_socket() const { return event_fd; }
+
+  bool drain() {
+    uint64_t counter{};
+    const auto result =
+      handle_eintr([&] { return ::read(event_fd, &counter, sizeof(counter)); });
+    return result == ssize_t(sizeof(counter));
+  }
+
+  bool signal() {
+    const uint64_t increment = 1;
+    const auto result =
+      handle_eintr([&] { return ::write(event_fd, &increment, sizeof(increment)); });
+    return result == ssize_t(sizeof(increment));
+  }
+};
+
 #else
 
 class PollCanceller {
@@ -1599,7 +2247,31 @@ class PollCanceller {
 
 #endif
 
+// Negative timeouts wait indefinitely. Timeouts are rounded up so that the wait never ends before
+// the requested time.
+static int timeout_ns_to_ms(int64_t timeout_ns) {
+  if (timeout_ns < 0) {
+    return -1;
+  }
+  const auto timeout_ms = (timeout_ns + 999'999) / 1'000'000;
+  return int(std::min<int64_t>(timeout_ms, std::numeric_limits<int>::max()));
+}
+
+static int64_t timeout_ms_to_ns(int timeout_ms) {
+  return timeout_ms < 0 ? -1 : int64_t(timeout_ms) * 1'000'000;
+}
+
+#if defined(SOCKLIB_LINUX)
+static timespec timeout_ns_to_timespec(int64_t timeout_ns) {
+  return timespec{
+    .tv_sec = time_t(timeout_ns / 1'000'000'000),
+    .tv_nsec = long(timeout_ns % 1'000'000'000),
+  };
+}
+#endif
+
 class PollerImpl : public sock::Poller {
+ protected:
 #if defined(SOCKLIB_WINDOWS)
   using RawEntry = WSAPOLLFD;
 #else
@@ -1607,66 +2279,104 @@ class PollerImpl : public sock::Poller {
 #endif
 
   std::vector<RawEntry> raw_entries;
+  std::vector<PollEntry*> registered_entries;
+  std::vector<PollEntry*> signaled_registered_entries;
 
   std::unique_ptr<PollCanceller> canceller;
   std::atomic_bool cancel_pending{false};
 
- public:
-  explicit PollerImpl(const CreateParameters& create_parameters) {
-    if (create_parameters.enable_cancellation) {
-      canceller = std::make_unique<PollCanceller>();
+  static short query_events_to_raw(QueryEvents query_events) {
+    short events{};
+    if ((query_events & QueryEvents::CanReceiveFrom) == QueryEvents::CanReceiveFrom) {
+      events |= POLLIN;
+    }
+    if ((query_events & QueryEvents::CanSendTo) == QueryEvents::CanSendTo) {
+      events |= POLLOUT;
     }
+    return events;
   }
 
-  operator bool() const {
-    if (canceller && !canceller->valid()) {
-      return false;
+  static void raw_events_to_status(short raw_events, PollEntry& entry) {
+    const auto set_event = [&](int raw_flag, StatusEvents flag) {
+      if (raw_events & raw_flag) {
+        entry.status_events = entry.status_events | flag;
+      }
+    };
+
+    set_event(POLLERR, StatusEvents::Error);
+    set_event(POLLHUP, StatusEvents::Disconnected);
+    set_event(POLLNVAL, StatusEvents::InvalidSocket);
+    set_event(POLLIN, StatusEvents::CanReceiveFrom);
+    set_event(POLLOUT, StatusEvents::CanSendTo);
+  }
+
+  void clear_signaled_registered_entries() {
+    for (const auto entry : signaled_registered_entries) {
+      entry->status_events = {};
     }
-    return true;
+    signaled_registered_entries.clear();
   }
 
-  sock::Result<size_t> poll(std::span<PollEntry> entries, int timeout_ms) override {
-    if (entries.empty() && !canceller) {
-      if (timeout_ms > 0) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
-      } else if (timeout_ms < 0) {
-        std::this_thread::sleep_for(std::chrono::hours(24));
+  void forget_registered_entry(PollEntry& entry) {
+    entry.registered_socket = sock::detail::invalid_raw_socket;
+    entry.registered_query_events = {};
+
+    if (entry.status_events != StatusEvents::None) {
+      entry.status_events = {};
+      std::erase(signaled_registered_entries, &entry);
+    }
+  }
+
+  // Returns true if the previous cancellation request was still pending and got consumed.
+  bool consume_pending_cancellation() {
+    if (canceller && cancel_pending) {
+      if (canceller->drain()) {
+        cancel_pending = false;
+        return true;
       }
-      return {
-        .status = {},
-        .value = 0,
-      };
     }
+    return false;
+  }
 
-    raw_entries.resize(entries.size());
+  sock::Status handle_cancellation_events(bool signaled_input, bool signaled_error) {
+    bool cancellation_error = signaled_error;
 
-    for (size_t i = 0; i < entries.size(); i++) {
-      auto& source = entries[i];
-      auto& dest = raw_entries[i];
+    if (signaled_input) {
+      if (canceller->drain()) {
+        cancel_pending.store(false);
+      } else {
+        cancellation_error = true;
+      }
+    }
 
-      source.status_events = {};
+    if (cancellation_error) {
+      return sock::Status{sock::Error::PollFailed, sock::Error::CancellationFailed};
+    }
 
-      dest.fd = source.socket ? sock::detail::RawSocketAccessor::get(*source.socket)
-                              : sock::detail::RawSocket(-1);
-      dest.events = {};
+    return {};
+  }
 
-      if ((source.query_events & QueryEvents::CanReceiveFrom) == QueryEvents::CanReceiveFrom) {
-        dest.events |= POLLIN;
-      }
-      if ((source.query_events & QueryEvents::CanSendTo) == QueryEvents::CanSendTo) {
-        dest.events |= POLLOUT;
+  // Polls `raw_entries` (which must contain exactly `entry_count` entries) together with the
+  // cancellation socket.
+  sock::Result<size_t> poll_raw_entries(size_t entry_count, int64_t timeout_ns) {
+    if (entry_count == 0 && !canceller) {
+      if (timeout_ns > 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(timeout_ns));
+      } else if (timeout_ns < 0) {
+        std::this_thread::sleep_for(std::chrono::hours(24));
       }
+      return {
+        .status = {},
+        .value = 0,
+      };
     }
 
     if (canceller) {
-      if (cancel_pending) {
-        if (canceller->drain()) {
-          cancel_pending = false;
-          return {
-            .status = {},
-            .value = {},
-          };
-        }
+      if (consume_pending_cancellation()) {
+        return {
+          .status = {},
+          .value = {},
+        };
       }
 
       raw_entries.push_back({
@@ -1676,11 +2386,19 @@ class PollerImpl : public sock::Poller {
     }
 
 #if defined(SOCKLIB_WINDOWS)
-    const auto poll_result = handle_eintr(
-      [&] { return ::WSAPoll(raw_entries.data(), ULONG(raw_entries.size()), timeout_ms); });
+    const auto poll_result = handle_eintr([&] {
+      return ::WSAPoll(raw_entries.data(), ULONG(raw_entries.size()), timeout_ns_to_ms(timeout_ns));
+    });
+#elif defined(SOCKLIB_LINUX)
+    const auto timeout = timeout_ns_to_timespec(timeout_ns);
+    const auto poll_result = handle_eintr([&] {
+      return ::ppoll(raw_entries.data(), nfds_t(raw_entries.size()),
+                     timeout_ns < 0 ? nullptr : &timeout, nullptr);
+    });
 #else
-    const auto poll_result =
-      handle_eintr([&] { return ::poll(raw_entries.data(), int(raw_entries.size()), timeout_ms); });
+    const auto poll_result = handle_eintr([&] {
+      return ::poll(raw_entries.data(), nfds_t(raw_entries.size()), timeout_ns_to_ms(timeout_ns));
+    });
 #endif
 
     if (is_error(poll_result)) {
@@ -1692,21 +2410,12 @@ class PollerImpl : public sock::Poller {
     auto signaled_entries = size_t(poll_result);
 
     if (canceller) {
-      if (const auto& last = raw_entries[entries.size()]; last.revents) {
-        const bool signaled_input = last.revents & POLLIN;
-        bool cancellation_error = last.revents & (POLLERR | POLLHUP | POLLNVAL);
-
-        if (signaled_input) {
-          if (canceller->drain()) {
-            cancel_pending.store(false);
-          } else {
-            cancellation_error = true;
-          }
-        }
-
-        if (cancellation_error) {
+      if (const auto& last = raw_entries[entry_count]; last.revents) {
+        const auto status = handle_cancellation_events(
+          last.revents & POLLIN, last.revents & (POLLERR | POLLHUP | POLLNVAL));
+        if (!status) {
           return {
-            .status = sock::Status{sock::Error::PollFailed, sock::Error::CancellationFailed},
+            .status = status,
           };
         }
 
@@ -1714,26 +2423,53 @@ class PollerImpl : public sock::Poller {
       }
     }
 
-    if (signaled_entries > 0) {
-      for (size_t i = 0; i < entries.size(); i++) {
-        const auto& source = raw_entries[i];
-        if (!source.revents) {
-          continue;
-        }
+    return {
+      .status = {},
+      .value = signaled_entries,
+    };
+  }
+
+ public:
+  explicit PollerImpl(const CreateParameters& create_parameters) {
+    if (create_parameters.enable_cancellation) {
+      canceller = std::make_unique<PollCanceller>();
+    }
+  }
+
+  operator bool() const {
+    if (canceller && !canceller->valid()) {
+      return false;
+    }
+    return true;
+  }
 
-        auto& dest = entries[i];
+  sock::Result<size_t> poll(std::span<PollEntry> entries, int timeout_ms) override {
+    raw_entries.resize(entries.size());
 
-        const auto set_event = [&](int raw_flag, StatusEvents flag) {
-          if (source.revents & raw_flag) {
-            dest.status_events = dest.status_events | flag;
-          }
-        };
+    for (size_t i = 0; i < entries.size(); i++) {
+      auto& source = entries[i];
+      auto& dest = raw_entries[i];
 
-        set_event(POLLERR, StatusEvents::Error);
-        set_event(POLLHUP, StatusEvents::Disconnected);
-        set_event(POLLNVAL, StatusEvents::InvalidSocket);
-        set_event(POLLIN, StatusEvents::CanReceiveFrom);
-        set_event(POLLOUT, StatusEvents::CanSendTo);
+      source.status_events = {};
+
+      dest.fd = source.socket ? sock::detail::RawSocketAccessor::get(*source.socket)
+                              : sock::detail::RawSocket(-1);
+      dest.events = query_events_to_raw(source.query_events);
+    }
+
+    const auto [poll_status, signaled_entries] =
+      poll_raw_entries(entries.size(), timeout_ms_to_ns(timeout_ms));
+    if (!poll_status) {
+      return {
+        .status = poll_status,
+      };
+    }
+
+    if (signaled_entries > 0) {
+      for (size_t i = 0; i < entries.size(); i++) {
+        if (const auto& source = raw_entries[i]; source.revents) {
+          raw_events_to_status(source.revents, entries[i]);
+        }
       }
     }
 
@@ -1753,18 +2489,317 @@ class PollerImpl : public sock::Poller {
       return false;
     }
   }
+
+  // Registration is emulated on top of poll(): the whole registered set is passed to the OS on
+  // every call.
+
+  sock::Status add_entry(PollEntry& entry) override {
+    if (entry.is_registered() || !entry.socket || !entry.socket->valid()) {
+      return {sock::Error::PollRegistrationFailed};
+    }
+
+    entry.registered_socket = sock::detail::RawSocketAccessor::get(*entry.socket);
+    entry.registered_query_events = entry.query_events;
+    entry.registration_index = registered_entries.size();
+    entry.status_events = {};
+
+    registered_entries.push_back(&entry);
+
+    return {};
+  }
+
+  sock::Status modify_entry(PollEntry& entry) override {
+    if (!entry.is_registered()) {
+      return {sock::Error::PollRegistrationFailed};
+    }
+
+    entry.registered_query_events = entry.query_events;
+
+    return {};
+  }
+
+  sock::Status remove_entry(PollEntry& entry) override {
+    if (!entry.is_registered()) {
+      return {};
+    }
+
+    const auto last_entry = registered_entries.back();
+    if (last_entry != &entry) {
+      last_entry->registration_index = entry.registration_index;
+      registered_entries[entry.registration_index] = last_entry;
+    }
+    registered_entries.pop_back();
+
+    forget_registered_entry(entry);
+
+    return {};
+  }
+
+  sock::Result<size_t> poll_registered(int64_t timeout_ns) override {
+    clear_signaled_registered_entries();
+
+    raw_entries.resize(registered_entries.size());
+
+    for (size_t i = 0; i < registered_entries.size(); i++) {
+      const auto& source = *registered_entries[i];
+      auto& dest = raw_entries[i];
+
+      dest.fd = source.registered_socket;
+      dest.events = query_events_to_raw(source.registered_query_events);
+    }
+
+    const auto [poll_status, signaled_count] =
+      poll_raw_entries(registered_entries.size(), timeout_ns);
+    if (!poll_status) {
+      return {
+        .status = poll_status,
+      };
+    }
+
+    if (signaled_count > 0) {
+      for (size_t i = 0; i < registered_entries.size(); i++) {
+        if (const auto& source = raw_entries[i]; source.revents) {
+          raw_events_to_status(source.revents, *registered_entries[i]);
+          signaled_registered_entries.push_back(registered_entries[i]);
+        }
+      }
+    }
+
+    return {
+      .status = {},
+      .value = signaled_registered_entries.size(),
+    };
+  }
+
+  std::span<PollEntry* const> signaled_entries() const override {
+    return signaled_registered_entries;
+  }
 };
 
+#if defined(SOCKLIB_LINUX)
+
+class EpollPollerImpl final : public PollerImpl {
+  constexpr static size_t initial_event_buffer_size = 256;
+
+  int epoll_fd{-1};
+  bool epoll_pwait2_unsupported{};
+
+  std::vector<epoll_event> events;
+
+  static uint32_t query_events_to_epoll(QueryEvents query_events) {
+    uint32_t events{};
+    if ((query_events & QueryEvents::CanReceiveFrom) == QueryEvents::CanReceiveFrom) {
+      events |= EPOLLIN;
+    }
+    if ((query_events & QueryEvents::CanSendTo) == QueryEvents::CanSendTo) {
+      events |= EPOLLOUT;
+    }
+    return events;
+  }
+
+  static void epoll_events_to_status(uint32_t raw_events, PollEntry& entry) {
+    const auto set_event = [&](uint32_t raw_flag, StatusEvents flag) {
+      if (raw_events & raw_flag) {
+        entry.status_events = entry.status_events | flag;
+      }
+    };
+
+    set_event(EPOLLERR, StatusEvents::Error);
+    set_event(EPOLLHUP, StatusEvents::Disconnected);
+    set_event(EPOLLIN, StatusEvents::CanReceiveFrom);
+    set_event(EPOLLOUT, StatusEvents::CanSendTo);
+  }
+
+  sock::Status control(int operation, int fd, PollEntry* entry, QueryEvents query_events) {
+    epoll_event event{};
+    event.events = query_events_to_epoll(query_events);
+    event.data.ptr = entry;
+
+    if (is_error(::epoll_ctl(epoll_fd, operation, fd, &event))) {
+      return last_error_to_status(sock::Error::PollRegistrationFailed);
+    }
+
+    return {};
+  }
+
+  int wait(int64_t timeout_ns) {
+#if defined(SOCKLIB_EPOLL_PWAIT2)
+    // Whole milliseconds can be passed to epoll_wait directly.
+    if (!epoll_pwait2_unsupported && timeout_ns > 0 && timeout_ns % 1'000'000 != 0) {
+      const auto timeout = timeout_ns_to_timespec(timeout_ns);
+      const auto result =
+        ::epoll_pwait2(epoll_fd, events.data(), int(events.size()), &timeout, nullptr);
+      if (!is_error(result) || errno != ENOSYS) {
+        return result;
+      }
+
+      // Kernels older than 5.11.
+      epoll_pwait2_unsupported = true;
+    }
+#endif
+
+    return ::epoll_wait(epoll_fd, events.data(), int(events.size()), timeout_ns_to_ms(timeout_ns));
+  }
+
+ public:
+  explicit EpollPollerImpl(const CreateParameters& create_parameters)
+      : PollerImpl(create_parameters) {
+    epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+      return;
+    }
+
+    if (canceller && canceller->valid()) {
+      // Null entry pointer identifies the cancellation socket.
+      if (!control(EPOLL_CTL_ADD, canceller->cancel_socket(), nullptr,
+                   QueryEvents::CanReceiveFrom)) {
+        ::close(epoll_fd);
+        epoll_fd = -1;
+      }
+    }
+
+    events.resize(initial_event_buffer_size);
+  }
+
+  ~EpollPollerImpl() override {
+    if (epoll_fd != -1) {
+      ::close(epoll_fd);
+    }
+  }
+
+  operator bool() const { return epoll_fd != -1 && PollerImpl::operator bool(); }
+
+  sock::Status add_entry(PollEntry& entry) override {
+    if (entry.is_registered() || !entry.socket || !entry.socket->valid()) {
+      return {sock::Error::PollRegistrationFailed};
+    }
+
+    const auto socket = sock::detail::RawSocketAccessor::get(*entry.socket);
+    if (const auto status = control(EPOLL_CTL_ADD, socket, &entry, entry.query_events); !status) {
+      return status;
+    }
+
+    entry.registered_socket = socket;
+    entry.registered_query_events = entry.query_events;
+    entry.status_events = {};
+
+    return {};
+  }
+
+  sock::Status modify_entry(PollEntry& entry) override {
+    if (!entry.is_registered()) {
+      return {sock::Error::PollRegistrationFailed};
+    }
+
+    const auto status = control(EPOLL_CTL_MOD, entry.registered_socket, &entry, entry.query_events);
+    if (status) {
+      entry.registered_query_events = entry.query_events;
+    }
+
+    return status;
+  }
+
+  sock::Status remove_entry(PollEntry& entry) override {
+    if (!entry.is_registered()) {
+      return {};
+    }
+
+    const auto status = control(EPOLL_CTL_DEL, entry.registered_socket, &entry, {});
+
+    forget_registered_entry(entry);
+
+    return status;
+  }
+
+  sock::Result<size_t> poll_registered(int64_t timeout_ns) override {
+    clear_signaled_registered_entries();
+
+    if (consume_pending_cancellation()) {
+      return {
+        .status = {},
+        .value = {},
+      };
+    }
+
+    const auto wait_result = handle_eintr([&] { return wait(timeout_ns); });
+    if (is_error(wait_result)) {
+      return {
+        .status = last_error_to_status(sock::Error::PollFailed),
+      };
+    }
+
+    for (size_t i = 0; i < size_t(wait_result); ++i) {
+      const auto& event = events[i];
+
+      const auto entry = static_cast<PollEntry*>(event.data.ptr);
+      if (!entry) {
+        const auto status =
+          handle_cancellation_events(event.events & EPOLLIN, event.events & (EPOLLERR | EPOLLHUP));
+        if (!status) {
+          return {
+            .status = status,
+          };
+        }
+        continue;
+      }
+
+      epoll_events_to_status(event.events, *entry);
+      signaled_registered_entries.push_back(entry);
+    }
+
+    // Level triggered, anything that didn't fit will be reported in the next call.
+    if (size_t(wait_result) == events.size()) {
+      events.resize(events.size() * 2);
+    }
+
+    return {
+      .status = {},
+      .value = signaled_registered_entries.size(),
+    };
+  }
+};
+
+#endif
+
 std::unique_ptr<sock::Poller> sock::Poller::create(const CreateParameters& create_parameters) {
   if (!initialize_sockets()) {
     return nullptr;
   }
+#if defined(SOCKLIB_LINUX)
+  auto impl = std::make_unique<EpollPollerImpl>(create_parameters);
+#else
   auto impl = std::make_unique<PollerImpl>(create_parameters);
+#endif
   if (!*impl) {
     return nullptr;
   }
   return impl;
 }
+
+sock::Status sock::Poller::update_entry(PollEntry& entry) {
+  const auto socket = entry.socket ? detail::RawSocketAccessor::get(*entry.socket)
+                                   : detail::invalid_raw_socket;
+
+  if (entry.is_registered()) {
+    if (entry.registered_socket == socket) {
+      if (entry.registered_query_events == entry.query_events) {
+        return {};
+      }
+      return modify_entry(entry);
+    }
+
+    if (const auto status = remove_entry(entry); !status) {
+      return status;
+    }
+  }
+
+  if (!is_valid_socket(socket)) {
+    return {};
+  }
+
+  return add_entry(entry);
+}
+
 bool sock::Poller::PollEntry::has_events(StatusEvents events) const {
   return (status_events & events) == events;
 }
@@ -168,6 +168,43 @@ class DatagramSocket : public detail::RwSocket {
   Result<size_t> send(const void* data, size_t data_size);
   Result<size_t> receive(void* data, size_t data_size);
 
+  // UDP segmentation offload (Linux only). Send slots with non-zero `segment_size` are split into
+  // datagrams of that size by the kernel (GSO), up to `max_send_segments` of them. With receive
+  // coalescing enabled (GRO) a single receive slot can get multiple datagrams of the same size
+  // from one sender, in which case their size is reported in its `segment_size`.
+  constexpr static size_t max_send_segments = 64;
+  static bool is_segmentation_offload_supported();
+  Status set_receive_coalescing(bool coalescing_enabled);
+
+  // Destination of a single datagram received by `receive_many`. The sender's address is written
+  // to `from` (if it's not null) and the datagram size to `size`.
+  struct ReceiveSlot {
+    std::span<uint8_t> data;
+    SocketAddress* from{};
+    size_t size{};
+    size_t segment_size{};
+  };
+
+  // Receives up to `max_receive_slots` datagrams with a single call (`recvmmsg` on Linux, one
+  // `recvfrom` per datagram elsewhere) and returns how many were received. It only fails with
+  // `WouldBlock` if no datagram was available.
+  constexpr static size_t max_receive_slots = 64;
+  Result<size_t> receive_many(std::span<ReceiveSlot> slots);
+
+  // Single datagram sent by `send_many`. The number of bytes sent is written to `size`.
+  struct SendSlot {
+    std::span<const uint8_t> data;
+    const SocketAddress* to{};
+    size_t segment_size{};
+    size_t size{};
+  };
+
+  // Sends up to `max_send_slots` datagrams with a single call (`sendmmsg` on Linux, one `sendto`
+  // per datagram elsewhere) and returns how many were sent. It only fails if the first datagram
+  // couldn't be sent, the error of any later one is reported by the next call which starts at it.
+  constexpr static size_t max_send_slots = 64;
+  Result<size_t> send_many(std::span<SendSlot> slots);
+
   Result<size_t> send_to(const SocketAddress& to, std::span<const uint8_t> data) {
     return send_to(to, data.data(), data.size());
   }
@@ -179,6 +216,42 @@ class DatagramSocket : public detail::RwSocket {
   Result<size_t> receive(std::span<uint8_t> data) { return receive(data.data(), data.size()); }
 };
 
+// Kernel pipe used to move data between stream sockets with `splice` without copying it to
+// userspace (Linux only).
+class KernelPipe {
+  friend class StreamSocket;
+
+  int read_end_ = -1;
+  int write_end_ = -1;
+  size_t capacity_ = 0;
+
+  KernelPipe(int read_end, int write_end, size_t capacity)
+      : read_end_(read_end), write_end_(write_end), capacity_(capacity) {}
+
+  void close();
+
+ public:
+  constexpr static size_t default_capacity = 1024 * 1024;
+
+  // Capacity is a hint, the kernel may round it or limit it (`/proc/sys/fs/pipe-max-size`).
+  static Result<KernelPipe> create(size_t capacity = default_capacity);
+
+  KernelPipe() = default;
+
+  KernelPipe(KernelPipe&& other) noexcept;
+  KernelPipe& operator=(KernelPipe&& other) noexcept;
+
+  KernelPipe(const KernelPipe& other) = delete;
+  KernelPipe& operator=(const KernelPipe& other) = delete;
+
+  ~KernelPipe();
+
+  bool valid() const { return read_end_ >= 0; }
+  operator bool() const { return valid(); }
+
+  size_t capacity() const { return capacity_; }
+};
+
 class StreamSocket : public detail::RwSocket {
   friend class Listener;
   friend class ConnectingStreamSocket;
@@ -222,11 +295,42 @@ class StreamSocket : public detail::RwSocket {
   Status set_keep_alive(bool keep_alive_enabled);
   Status set_no_delay(bool no_delay_enabled);
 
+  // Zero-copy sends (`SO_ZEROCOPY`, Linux only). `send_zero_copy` makes the kernel reference the
+  // data instead of copying it, so it must stay alive and unmodified until a completion covering
+  // that call is received. Completions are queued on the socket error queue, which pollers report
+  // as an error event, and every successful `send_zero_copy` call is counted starting from 0.
+  struct ZeroCopyCompletion {
+    uint32_t first_send{};
+    uint32_t last_send{};
+    // The kernel had to copy the data anyway (e.g. on loopback).
+    bool copied{};
+  };
+  Status set_zero_copy(bool zero_copy_enabled);
+  Result<size_t> send_zero_copy(std::span<const uint8_t> data);
+  // Fails with `WouldBlock` when there are no more completions queued.
+  Result<ZeroCopyCompletion> receive_zero_copy_completion();
+
   Result<size_t> send(const void* data, size_t data_size);
   Result<size_t> send_all(const void* data, size_t data_size);
   Result<size_t> receive(void* data, size_t data_size);
   Result<size_t> receive_exact(void* data, size_t data_size);
 
+  // Sends multiple buffers with a single call (`sendmsg` / `WSASend`), as if they were
+  // concatenated. Up to `max_vectored_buffers` buffers are sent at once, the returned size tells
+  // how much of the data was actually sent.
+  constexpr static size_t max_vectored_buffers = 64;
+  Result<size_t> send_vectored(std::span<const std::span<const uint8_t>> buffers);
+
+  // Move up to `size` bytes between the socket and the pipe with `splice` (Linux only). Receiving
+  // 0 bytes fails with `Disconnected` like `receive`. Both calls are non-blocking even if the
+  // socket isn't.
+  Result<size_t> receive_to_pipe(KernelPipe& pipe, size_t size);
+  Result<size_t> send_from_pipe(KernelPipe& pipe, size_t size);
+
+  // Sends up to `size` bytes of the file starting at `offset` with `sendfile` (Linux only).
+  static bool is_send_file_supported();
+  Result<size_t> send_file(int file_descriptor, uint64_t offset, size_t size);
+
   Result<size_t> send(std::span<const uint8_t> data) { return send(data.data(), data.size()); }
   Result<size_t> send_all(std::span<const uint8_t> data) {
     return send_all(data.data(), data.size());
@@ -344,12 +448,39 @@ class Poller {
     QueryEvents query_events{};
     StatusEvents status_events{};
 
+    // Not used by the poller, can be used to identify the owner of a registered entry.
+    void* user_data{};
+    uint32_t user_tag{};
+
+    // Managed by the poller for persistently registered entries.
+    detail::RawSocket registered_socket{detail::invalid_raw_socket};
+    QueryEvents registered_query_events{};
+    size_t registration_index{};
+
     bool has_events(StatusEvents events) const;
     bool has_any_event(StatusEvents events) const;
+
+    bool is_registered() const { return registered_socket != detail::invalid_raw_socket; }
   };
 
   virtual Result<size_t> poll(std::span<PollEntry> entries, int timeout_ms) = 0;
   virtual bool cancel() = 0;
+
+  // Persistent registration. Registered entries must stay at the same address and must be removed
+  // before their socket is closed. `poll_registered` sets `status_events` of registered entries.
+  // Its timeout is in nanoseconds (negative waits indefinitely); backends which cannot wait with
+  // that precision round it up to whole milliseconds.
+  virtual Status add_entry(PollEntry& entry) = 0;
+  virtual Status modify_entry(PollEntry& entry) = 0;
+  virtual Status remove_entry(PollEntry& entry) = 0;
+  virtual Result<size_t> poll_registered(int64_t timeout_ns) = 0;
+
+  // Registered entries signaled by the last `poll_registered` call. Removing an entry removes it
+  // from this list, so the returned span is invalidated by `remove_entry`.
+  virtual std::span<PollEntry* const> signaled_entries() const = 0;
+
+  // Adds, modifies or removes the registration to match current `socket` and `query_events`.
+  Status update_entry(PollEntry& entry);
 };
 
 SOCKLIB_IMPLEMENT_ENUM_BIT_OPERATIONS(Poller::QueryEvents)